@@ -36,597 +36,414 @@
  *	@Version 1.0.0 		
  */
 
-#include "sys/alt_stdio.h"   			//for the alt_putstr function below.  Outputs to Eclipse console
-#include "altera_avalon_pio_regs.h"  	//for the I/O functions in the while loop below
-#include "sys/alt_timestamp.h"  		//Timestamp Driver
-#include "system.h"
-
-#define setHeaderOuts HEADEROUTPUTS_BASE+0x10  	//HEADEROUTPUTS_BASE is defined in system.h of the _bsp file.  It refers to the base address in the Qsys design
-												//the hex offset (in this case 0x10, which is 16 in decimal) gives the number of bytes of offset
-												//each register is 32 bits, or 4 bytes
-												//so to shift to register 4, which is the outset register, we need 4 * (4 bytes) = 16 bytes
-#define clearHeaderOuts HEADEROUTPUTS_BASE+0x14 //to shift to register 5 (the 'outclear' register) we need to shift by 5 * (4 bytes) = 20 bytes, (=0x14 bytes)
-												// offset of 5 corresponds to the 'outclear' register of the PIO.
-
-int dig(int counter);							//Defines the dig function
-int distance_get(int CM_M,int DP, int LED);		//Defines the Distance Get function
-int sseg(int distance,int DP);					//Defines the SSEG function
-void timer(int secs);							//Defines the timer function
+#include "hal.h"							//for the board I/O, timestamp and alt_putstr functions
+#include "timebase.h"						//for the monotonic 64-bit time base
+#include "ranger.h"							//for the non-blocking SRF05 ranging engine
+#include "convert.h"						//for the fixed point distance conversion
+#include "sseg.h"							//for the SSEG display renderer
+#include "sched.h"							//for the cooperative task scheduler
+#include "show.h"							//for the timed display sequences
+#include "stats.h"							//for the reading statistics
+#include "filter.h"							//for the constant read noise filter
+#include "cadence.h"						//for the adaptive ping cadence
+#include "input.h"							//for the debounced switches and buttons
+#include "store.h"							//for the flash backed settings store
+#include "slots.h"							//for the save slots
+#include "output.h"							//for the SSEG, LED and header output driver
+#include "console.h"						//for the JTAG UART console commands
+#include "probe.h"							//for the timing probes
+#include "telemetry.h"						//for the binary telemetry stream
+#include "autorange.h"						//for the auto-ranging display
+#include "burst.h"							//for the oversampling bursts
+#include "edges.h"							//for the echo and button edge interrupts
+#include "logger.h"							//for the SDRAM sample logger
+#include "calib.h"							//for the sensor calibration
+#include "alarm.h"							//for the proximity alarm zones
+#include "track.h"							//for the target tracker
+
+#define READ_NONE		0					//No reading in progress
+#define READ_SINGLE		1					//One reading that is saved when it finishes
+#define READ_CONSTANT	2					//Constant read, until the CR switch is turned off
+
+#define SHOW_NAME		TIMEBASE_SEC(2)		//Time a name(CE, SV1, hi...) is shown for
+#define SHOW_VALUE		TIMEBASE_SEC(3)		//Time a saved value is shown for
+
+int distance_calc(int timer,int CM_M,int DP, int LED);	//Defines the Distance Calc function
+int display_word(int ticks,int CM_M,int DP);	//Defines the Display Word function
+int slot_word(int slot,int CM_M,int DP);		//Defines the Slot Word function
+void input_changed(input_event event,int which);	//Defines the Input Changed function
+void button_pressed(int button);				//Defines the Button Pressed function
+void range_task(void);							//Defines the Range task
+void reading_start(void);						//Defines the Reading Start function
+void stats_report(void);						//Defines the Stats Report function
+int sensor_echo(ranger_state state,alt_u64 *time);	//Defines the Sensor Echo function
+void sensor_select(void);						//Defines the Sensor Select function
+
+int reading = READ_NONE;						//Type of reading in progress
+int range_id;									//Scheduler id of the Range task
+int sensor = -1;								//Sensor shown on the display, LEDs and statistics, -1 for the nearest
+
+int CR;											//Saves the On or Off state of constant read on SW0
+int CM_M;										//Saves the CM or M state on SW1
+int LED;										//Saves the On or Off state of LED on SW2
+int DP;											//Saves the On or Off state of Decimal point on SW3
+int LOAD;										//Saves the Load or Read state on SW4
+int SV;											//Saves the On or Off states of save 1 to 5 on SW5 to SW9, save n in bit n - 1
+
+int disp = SSEG_BLANK_WORD;						//for saving the SSEG display value
 
 /*################################################################*/
 
 int  main(void)
 {
-	alt_putstr("Project 1: CM & M Distance Measurement - Marcus Masdammer");
-
-	int buttons; 								//for button states on the DE0 board
-	int distance;								//for distance that was calculated
-	int settings;								//for switch settings
-	int disp;									//for saving the SSEG display value
-
-	int CR;										//Saves the On or Off state of constant read on SW0
-	int CM_M;									//Saves the CM or M state on SW1
-	int LED;									//Saves the On or Off state of LED on SW2
-	int DP;										//Saves the On or Off state of Decimal point on SW3
-	int LOAD;									//Saves the Load or Read state on SW4
-	int SV_1;									//Saves the On or Off state of save 1 on SW5
-	int SV_2;									//Saves the On or Off state of save 2 on SW6
-	int SV_3;									//Saves the On or Off state of save 3 on SW7
-	int SV_4;									//Saves the On or Off state of save 4 on SW8
-	int SV_5;									//Saves the On or Off state of save 5 on SW9
-
-	int hi = 0;									//Highest value
-	int low = 10000;							//Lowest value
-
-	int save1 = 0xffffffff;						//Default of Save 1 as blank
-	int save2 = 0xffffffff;						//Default of Save 2 as blank
-	int save3 = 0xffffffff;						//Default of Save 3 as blank
-	int save4 = 0xffffffff;						//Default of Save 4 as blank
-	int save5 = 0xffffffff;						//Default of Save 5 as blank
-
-	int save1_M = 0xffffffff;					//Default of Save 1 Meter as blank
-	int save2_M = 0xffffffff;					//Default of Save 2 Meter as blank
-	int save3_M = 0xffffffff;					//Default of Save 3 Meter as blank
-	int save4_M = 0xffffffff;					//Default of Save 4 Meter as blank
-	int save5_M = 0xffffffff;					//Default of Save 5 Meter as blank
+	hal_putstr("Project 1: CM & M Distance Measurement - Marcus Masdammer");
+	timebase_init();							//Start the timestamp counter
+	output_init();								//Clear the SSEG display, LEDs and header outputs
+	ranger_init();								//Turn the trigger off
+	sseg_init();								//Build the SSEG display word cache
+	autorange_init();							//Work out the display format thresholds
+	burst_config(1,BURST_MEDIAN);				//One ping per value until changed from the console
+	filter_init(FILTER_DEFAULT_MODE,FILTER_DEFAULT_WINDOW);	//Select the constant read filter
+	store_init();								//Restore the saved settings from flash
+	slots_init();								//and the save slots
+	calib_init();								//and the sensor calibration
+	alarm_init();								//and the alarm zones
+
+	range_id = sched_add(range_task);			//Add the tasks to the scheduler
+	edges_init(RANGER_ALL);						//Timestamp echo and button edges as they happen
+	edges_wake(EDGES_ECHO,range_id);			//and run the Range task for each echo edge
+	show_init();
+	input_init(input_changed);					//Start reading the switches and buttons
+	console_init();								//Start reading console commands
+	probe_init();
+	telemetry_init();
+	burst_init();
+	cadence_init();
+	logger_init();
+	track_init();
+	console_add('s',stats_report,"reading statistics over the last 5s");	//Window statistics on the console
+	console_add('S',sensor_select,"<n>S show sensor n, the nearest with no number");	//Sensor to show, set from the console
+	telemetry_input(input_word());				//Inputs at power on, for traces
 
 	while(1)//Infinite loop
 	{
-		buttons=IORD_ALTERA_AVALON_PIO_DATA(PUSHBUTTONS1_2_BASE);		//Read button states
+		sched_run();							//Run every task that is due
+	}
+}
 
-		while((buttons & 0x01)+(buttons & 0x02)==3)						//While none of the buttons are pressed
-		{
-			buttons=IORD_ALTERA_AVALON_PIO_DATA(PUSHBUTTONS1_2_BASE);	//Read button states
-		}
+//############################################################################################################################################
 
-		settings=IORD_ALTERA_AVALON_PIO_DATA(DE0SWITCHES_BASE);			//Read Switch states
 
-		CR = ((settings) - ((settings >> 1) << 1));						//Read Constant read switch state
-		CM_M = ((settings >> 1) - ((settings >> 2) << 1));				//Read CM or M switch state
-		LED = ((settings >> 2) - ((settings >> 3) << 1));				//Read LED switch state
-		DP = ((settings >> 3) - ((settings >> 4) << 1));				//Read Decimal Point switch state
-		LOAD = ((settings >> 4) - ((settings >> 5) << 1));				//Read Load switch state
-		SV_1 = ((settings >> 5) - ((settings >> 6) << 1));				//Read Save 1 switch state
-		SV_2 = ((settings >> 6) - ((settings >> 7) << 1));				//Read Save 2 switch state
-		SV_3 = ((settings >> 7) - ((settings >> 8) << 1));				//Read Save 3 switch state
-		SV_4 = ((settings >> 8) - ((settings >> 9) << 1));				//Read Save 4 switch state
-		SV_5 = ((settings >> 9) - ((settings >> 10) << 1));				//Read Save 5 switch state
+//Acts on a debounced button press or switch change
+void input_changed(input_event event,int which)
+{
+	const input_settings *settings = input_get();
+
+	telemetry_input(input_word());											//Record the inputs for replay
 
-		if (LOAD == 0)					//If Load switch is off
+	if(event == INPUT_PRESS)
+	{
+		button_pressed(which);
+	}
+	else if(event == INPUT_SWITCH && reading == READ_CONSTANT)				//Constant read follows the switches as they change
+	{
+		CM_M = settings->CM_M;
+		LED = settings->LED;
+		DP = settings->DP;
+
+		if((which & INPUT_SW_CR) && settings->CR == 0)						//If Constant Read Switch has been turned off
 		{
-			if(buttons == 2)			//If button 1 was pressed
-			{
-				while(CR == 1)			//While Constant Read Switch is On
-				{
-					settings=IORD_ALTERA_AVALON_PIO_DATA(DE0SWITCHES_BASE);	//Read Switch states
-
-					CR = ((settings) - ((settings >> 1) << 1));				//Read Constant read switch state
-					CM_M = ((settings >> 1) - ((settings >> 2) << 1));		//Read CM or M switch state
-					LED = ((settings >> 2) - ((settings >> 3) << 1));		//Read LED switch state
-					DP = ((settings >> 3) - ((settings >> 4) << 1));		//Read Decimal Point switch state
-
-					distance = distance_get(CM_M,DP,LED);					//Run Distance Get function and save the return as distance
-					if (distance < 10000)									//If distance return is less than 10000
-					{
-						IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,sseg(distance,DP));	//Display the distance on the SSEG Display
-
-						if((CM_M == 0) & (DP == 0))									//If CM_M and DP switches are Off
-						{
-							if(distance > hi)										//If Distance is higher than saved hi value
-							{
-								hi = distance;										//Save the new hi value
-							}
-							else if(distance < low)									//Else If Distance is lower than saved low value
-							{
-								low = distance;										//Save the new Low Value
-							}
-						}
-					}
-					else
-					{
-						IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,0x86Af2fff);			//If greater than 10000 display Err.
-					}
-				}
+			CR = 0;
+			reading = READ_SINGLE;											//Take one more reading and save it
+			reading_start();
+		}
+	}
+}
+//############################################################################################################################################
 
-				distance = distance_get(CM_M,DP,LED);								//Run Distance Get function and save the return as distance
-				if (distance < 10000)												//If distance return is less than 10000
-				{
-					disp = sseg(distance,DP);										//Display is the return of SSEG function of supplied distance and decimal point
-					IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,disp);					//Display the value using disp(return of SSEG function)
-
-					if((DP == 0) & (CM_M == 0))										//If CM_M and DP switches are Off
-					{
-						if(distance > hi)											//If Distance is higher than saved hi value
-						{
-							hi = distance;											//Save the new hi value
-						}
-						else if(distance < low)										//Else If Distance is lower than saved low value
-						{
-							low = distance;											//Save the new Low Value
-						}
-					}
 
-				}
-				else
-				{
-					IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,0x86Af2fff);				//If greater than 10000 display Err.
-				}
+//Acts on a button press using the switch settings at the time of the press
+void button_pressed(int button)
+{
+	const input_settings *settings = input_get();					//Debounced Switch states
+	int slot;
 
-				if(CM_M == 0)							//If CM mode
-				{
-					if(SV_1 == 1)						//If Save 1(SW5) is On
-					{
-						save1 = disp;					//Save the Display to Save state 1
-					}
-					if(SV_2 == 1)						//If Save 2(SW6) is On
-					{
-						save2 = disp;					//Save the Display to Save state 2
-					}
-					if(SV_3 == 1)						//If Save 3(SW7) is On
-					{
-						save3 = disp;					//Save the Display to Save state 3
-					}
-					if(SV_4 == 1)						//If Save 4(SW8) is On
-					{
-						save4 = disp;					//Save the Display to Save state 4
-					}
-					if(SV_5 == 1)						//If Save 5(SW9) is On
-					{
-						save5 = disp;					//Save the Display to Save state 5
-					}
-				}
-				else									//Else M mode
-				{
-					if(SV_1 == 1)						//If Save 1(SW5) is On
-					{
-						save1_M = disp;					//Save the Display to Save state 1 Meters
-					}
-					if(SV_2 == 1)						//If Save 2(SW6) is On
-					{
-						save2_M = disp;					//Save the Display to Save state 2 Meters
-					}
-					if(SV_3 == 1)						//If Save 3(SW7) is On
-					{
-						save3_M = disp;					//Save the Display to Save state 3 Meters
-					}
-					if(SV_4 == 1)						//If Save 4(SW8) is On
-					{
-						save4_M = disp;					//Save the Display to Save state 4 Meters
-					}
-					if(SV_5 == 1)						//If Save 5(SW9) is On
-					{
-						save5_M = disp;					//Save the Display to Save state 5 Meters
-					}
-				}
-			}
-			else if(buttons == 1)				//If Button 2 is pressed Reset selected saves and High + Low Values
-			{
-				hi = 0;							//Hi value reset to 0
-				low = 10000 ;					//Low Value reset to 10000
+	CR = settings->CR;												//Constant read switch state
+	CM_M = settings->CM_M;											//CM or M switch state
+	LED = settings->LED;											//LED switch state
+	DP = settings->DP;												//Decimal Point switch state
+	LOAD = settings->LOAD;											//Load switch state
+	SV = settings->SV;												//Save 1 to 5 switch states
 
-				if(CM_M == 0)					//Reset CM values
-				{
-					if(SV_1 == 1)				//If Save 1(SW5) is On
-					{
-						save1 = 0xffffffff;		//Reset Save state 1
-					}
-
-					if(SV_2 == 1)				//If Save 2(SW6) is On
-					{
-						save2 = 0xffffffff;		//Reset Save state 2
-					}
-
-					if(SV_3 == 1)				//If Save 3(SW7) is On
-					{
-						save3 = 0xffffffff;		//Reset Save state 3
-					}
-
-					if(SV_4 == 1)				//If Save 4(SW8) is On
-					{
-						save4 = 0xffffffff;		//Reset Save state 4
-					}
-
-					if(SV_5 == 1)				//If Save 5(SW9) is On
-					{
-						save5 = 0xffffffff;		//Reset Save state 5
-					}
-				}
-				else
-				{
-					if(SV_1 == 1)						//If Save 1(SW5) is On
-					{
-						save1_M = 0xffffffff;			//Reset Save state 1 Meters
-					}
-					if(SV_2 == 1)						//If Save 2(SW6) is On
-					{
-						save2_M = 0xffffffff;			//Reset Save state 2 Meters
-					}
-					if(SV_3 == 1)						//If Save 3(SW7) is On
-					{
-						save3_M = 0xffffffff;			//Reset Save state 3 Meters
-					}
-					if(SV_4 == 1)						//If Save 4(SW8) is On
-					{
-						save4_M = 0xffffffff;			//Reset Save state 4 Meters
-					}
-					if(SV_5 == 1)						//If Save 5(SW9) is On
-					{
-						save5_M = 0xffffffff;			//Reset Save state 5 Meters
-					}
-				}
-			}
+	show_stop();													//Any button press ends a display sequence
 
-		}
-		else if(LOAD == 1)								//Else If Load Switch is 1
+	if (LOAD == 0)					//If Load switch is off
+	{
+		if(button == 1)				//If button 1 was pressed
 		{
-			if(buttons == 2)							//If button 1 was pressed
+			if(reading == READ_NONE)								//If no reading is in progress
 			{
-					if(CM_M == 0)
-					{
-
-						IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,0xC606ffff);				//Display CE on SSEG display
-						timer(2);														//wait 2 seconds
-
-						if(SV_1 == 1)													//If Save 1 (SW5) is On
-						{
-							IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,0x12F9ffff);			//Display SV1 on SSEG display
-							timer(2);													//Wait 2 seconds
-
-							IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,save1);				//Display the saved value on SSEG display
-							timer(3);													//Wait 3 seconds
-						}
-
-						if(SV_2 == 1)													//If Save 2 (SW6) is On
-						{
-							IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,0x12A4ffff);			//Display SV2 on SSEG display
-							timer(2);													//Wait 2 seconds
-
-							IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,save2);				//Display the saved value on SSEG display
-							timer(3);													//Wait 3 seconds
-						}
-
-						if(SV_3 == 1)													//If Save 3 (SW7) is On
-						{
-							IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,0x12B0ffff);			//Display SV3 on SSEG display
-							timer(2);													//Wait 2 seconds
-
-							IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,save3);				//Display the saved value on SSEG display
-							timer(3);													//Wait 3 seconds
-						}
-
-						if(SV_4 == 1)													//If Save 4 (SW8) is On
-						{
-							IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,0x1299ffff);			//Display SV4 on SSEG display
-							timer(2);													//Wait 2 seconds
-
-							IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,save4);				//Display the saved value on SSEG display
-							timer(3);													//Wait 3 seconds
-						}
-
-						if(SV_5 == 1)													//If Save 4 (SW8) is On
-						{
-							IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,0x1292ffff);			//Display SV5 on SSEG display
-							timer(2); 													//Wait 2 seconds
-
-							IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,save5);				//Display the saved value on SSEG display
-							timer(3);													//Wait 3 seconds
-						}
-					}
-					else
-					{
-						IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,0x2BC606ff);				//Display nCE on SSEG display
-						timer(2);														//Wait 2 seconds
-
-						if(SV_1 == 1)													//If Save 1 (SW5) is On
-						{
-							IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,0x12F9ffff);			//Display SV1 on SSEG display
-							timer(2);													//Wait 2 seconds
-
-							IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,save1_M);				//Display the saved value on SSEG display
-							timer(3);													//Wait 3 seconds
-						}
-
-						if(SV_2 == 1)													//If Save 2 (SW6) is On
-						{
-							IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,0x12A4ffff);			//Display SV2 on SSEG display
-							timer(2);													//Wait 2 seconds
-
-							IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,save2_M);				//Display the saved value on SSEG display
-							timer(3);													//Wait 3 seconds
-						}
-
-						if(SV_3 == 1)													//If Save 3 (SW7) is On
-						{
-							IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,0x12B0ffff);			//Display SV3 on SSEG display
-							timer(2);													//Wait 2 seconds
-
-							IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,save3_M);				//Display the saved value on SSEG display
-							timer(3);													//Wait 3 seconds
-						}
-
-						if(SV_4 == 1)													//If Save 4 (SW8) is On
-						{
-							IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,0x1299ffff);			//Display SV4 on SSEG display
-							timer(2);													//Wait 2 seconds
-
-							IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,save4_M);				//Display the saved value on SSEG display
-							timer(3);													//Wait 3 seconds
-						}
-
-						if(SV_5 == 1)													//If Save 4 (SW8) is On
-						{
-							IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,0x1292ffff);			//Display SV5 on SSEG display
-							timer(2); 													//Wait 2 seconds
-
-							IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,save5_M);				//Display the saved value on SSEG display
-							timer(3);													//Wait 3 seconds
-						}
-
-					}
-				}
-				else if(buttons == 1)														//Else if Button 2 is pressed on the DE0 Board
-				{
-					//Displaying the Highest value ######################
-					IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,0x8B6FFFFF);						//Display hi on the SSEG display
-					timer(2);																//Wait 2 seconds
-					IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,sseg(hi,DP));						//Display the Hi value on the SSEG display
-					timer(3);																//Wait 3 seconds
-					//###################################################
-
-					//Displaying the Lowest value #######################
-					IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,0xC740FFFF);						//Display LO on the SSEG display
-					timer(2);																//Wait 2 seconds
-					IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,sseg(low,DP));					//Display the Low value on the SSEG display
-					timer(3);																//Wait 3 seconds
-					//###################################################
-				}
+				reading = (CR == 1) ? READ_CONSTANT : READ_SINGLE;	//Constant read if the CR switch is on
+				filter_reset();										//Constant read starts with an empty filter
+				track_reset();										//and tracker
+				cadence_reset();									//and a new achieved rate count
+				reading_start();									//Start the first reading
 			}
+		}
+		else if(button == 2)				//If Button 2 is pressed Reset selected saves and High + Low Values
+		{
+			stats_reset();					//Hi and Low values reset
+			slots_clear(SV,CM_M);			//Reset the save slots that are on, CM or M
+		}
+
+	}
+	else if(LOAD == 1)								//Else If Load Switch is 1
+	{
+		if(button == 1)								//If button 1 was pressed
+		{
+			show_add(CM_M == 0 ? SSEG_CE : SSEG_NCE,SHOW_NAME);				//Display CE or nCE on SSEG display for 2 seconds
 
-			while((buttons & 0x01)+(buttons & 0x02) != 3) 									//While any of the two buttons are still pressed
+			for(slot = 1; slot <= SLOTS; slot++)
 			{
-				buttons=IORD_ALTERA_AVALON_PIO_DATA(PUSHBUTTONS1_2_BASE);					//Read button state
+				if((SV >> (slot - 1)) & 1)									//If the slot's save switch(SW5 to SW9) is On
+				{
+					show_add(SSEG_SV(slot),SHOW_NAME);						//Display SVn on SSEG display for 2 seconds
+					show_add(slot_word(slot,CM_M,DP),SHOW_VALUE);			//Display the saved value on SSEG display for 3 seconds
+				}
 			}
+		}
+		else if(button == 2)												//Else if Button 2 is pressed on the DE0 Board
+		{
+			//Displaying the Highest value ######################
+			show_add(SSEG_HI,SHOW_NAME);									//Display hi on the SSEG display for 2 seconds
+			show_add(display_word(stats_high(),CM_M,DP),SHOW_VALUE);		//Display the Hi value on the SSEG display for 3 seconds
+			//###################################################
+
+			//Displaying the Lowest value #######################
+			show_add(SSEG_LO,SHOW_NAME);									//Display LO on the SSEG display for 2 seconds
+			show_add(display_word(stats_low(),CM_M,DP),SHOW_VALUE);			//Display the Low value on the SSEG display for 3 seconds
+			//###################################################
+		}
 	}
 }
-
 //############################################################################################################################################
 
 
-//Timer function to run for supplied amount of seconds #########
-void timer(int sec)
+//Range task, moves the reading on and displays and saves it when it finishes
+void range_task(void)
 {
-	int TS = 50000000;						//Ticks per second
-	int time = 0;							//Time reset
+	int echo = 0;															//for the echo length after filtering
+	alt_u64 echo_time;														//for the time the shown sensor's echo started
+	int channel;															//for the sensor of each telemetry record
+	ranger_state state = ranger_poll();										//Move the reading on
 
-	time=alt_timestamp_start();				//Start Timer
-	while(time <= (TS*sec))					//While Timer value is lower than Ticks x required seconds
+	if(state != RANGER_DONE && state != RANGER_ERROR)						//If the reading is still in progress
 	{
-		time=alt_timestamp();				//read tick amount
+		sched_wake(range_id,ranger_wait());									//Check it again at its next deadline, or sooner on an echo edge
+		return;
 	}
-	return;									//return to line that called this function
-}
-//###############################################################################################################################################
+	PROBE_BEGIN(PROBE_RESULT);												//Reading finished, time it to the display
 
+	if(telemetry_enabled() || logger_enabled() || calib_sampling())			//Send, log and calibrate with every sensor's raw result
+	{
+		for(channel = 0; channel < RANGER_CHANNELS; channel++)
+		{
+			ranger_err error = ranger_channel_error(channel);
+			int ended = error == RANGER_OK || error == RANGER_OUT_OF_RANGE;	//Echo was timed
+			alt_u64 time = ended ? ranger_channel_time(channel) : timebase_now();
+			int ticks = ended ? ranger_channel_raw(channel) : 0;
+
+			telemetry_add(time,channel,error,ticks);
+			PROBE_BEGIN(PROBE_LOG);
+			logger_add(time,channel,error,ticks);
+			PROBE_END(PROBE_LOG);
+			calib_sample(channel,error == RANGER_OK ? ticks : 0);
+		}
+	}
 
-//This Function uses the SRF05 Ultrasonic Rangefinder to Calculate distance
-int distance_get(int CM_M,int DP, int LED)
-{
-	int timer = 0;											//Define a Variable for the timers
-	char input = 0;											//Defines the input variable
-	float constant = 0;										//Defines the constant used to calculate range
+	echo = sensor_echo(state,&echo_time);									//Echo length of the shown sensor, -1 if it failed
+	if(burst_add(echo_time,echo))											//If the burst needs more pings
+	{
+		ranger_start();
+		sched_wake(range_id,0);
+		return;
+	}
+	echo = burst_result();													//Echo length of the burst, -1 if every ping failed
+	state = echo < 0 ? RANGER_ERROR : RANGER_DONE;							//A burst fails only if every ping failed
 
-	IOWR_ALTERA_AVALON_PIO_DATA(clearHeaderOuts,0x01);		//Turns off output pin 1
+	if(state == RANGER_DONE)												//If the reading was successful
+	{
 
-	if(DP == 1)												//If DP that was supplied is 1
+		if(reading == READ_CONSTANT)										//If Constant Read
 		{
-			constant = 0.34029/10;							//our constant will be divided by 10
+			PROBE_BEGIN(PROBE_FILTER);
+			echo = filter_add(burst_time(),echo);							//Filter out the noise
+			PROBE_END(PROBE_FILTER);
+			PROBE_BEGIN(PROBE_TRACK);
+			track_add(filter_time(),echo);									//Fit the target's movement to the filtered reading, at the time it was taken
+			PROBE_END(PROBE_TRACK);
 		}
-	else
+		alarm_approach(reading == READ_CONSTANT ? track_approach() : 0);	//Zones reach further for a target closing in
+		stats_add(burst_time(),echo);										//Add the reading to the statistics
+	}
+
+	if(state == RANGER_ERROR)												//If the reading failed after its retries
+	{
+		if(!show_busy())
 		{
-			constant = 0.34029;								//else stays the same
+			output_sseg(SSEG_ERR_CODE(sensor < 0 ? ranger_error() : ranger_channel_error(sensor)));	//Display Err.1 no echo, Err.2 echo too long, Err.3 out of range
 		}
 
-	if(CM_M == 1)											//If CM_M value that was supplied is 1
+		if(reading == READ_CONSTANT)
 		{
-			constant = constant/100;						//Constant will be divided by 100 else do nothing
+			reading_start();												//Keep trying in Constant Read
 		}
+		else
+		{
+			reading = READ_NONE;											//Failed readings are not saved
+		}
+		return;
+	}
 
-	timer=alt_timestamp_start();							//Start timer
-
-
-	while(timer < 2500000) 									//While timer is less than 50ms
+	if(reading == READ_CONSTANT && track_predicting())
 	{
-		timer=alt_timestamp();								//Read timer
+		echo = track_predict(timebase_now());								//Show where the filtered readings put the target now, not where it was
 	}
 
-	IOWR_ALTERA_AVALON_PIO_DATA(setHeaderOuts,0x01);		//Turn on Output Signal of pin 1
+	distance_calc(echo,CM_M,DP,LED);										//Convert the finished reading to a distance for the LEDs
 
-	timer=alt_timestamp_start();							//Start Timer
-
-	while(timer < 501)										//Wait for 501 ticks(Time for signal to reach the SRF05)
+	if(reading == READ_CONSTANT)
 	{
-		timer = alt_timestamp();
+		reading_start();													//Start the next reading while this one is displayed
 	}
 
-	IOWR_ALTERA_AVALON_PIO_DATA(clearHeaderOuts,0x01);		//Turn Off output signal on pin 1
-
-	input=IORD_ALTERA_AVALON_PIO_DATA(HEADERINPUTS_BASE);	//Input pins state saved to input
+	PROBE_BEGIN(PROBE_RENDER);
+	disp = autorange_word(echo,CM_M,DP);									//Display word in the switch format, or the next one of its unit the distance fits in
+	PROBE_END(PROBE_RENDER);
+	if(!show_busy())														//Unless a display sequence is playing
+	{
+		output_sseg(disp);													//Display the value using disp(return of SSEG function)
+	}
+	PROBE_END(PROBE_RESULT);
 
-	while(((input)&(0x01)) == 0)							//Wait for no signals
+	if(reading == READ_CONSTANT)											//Constant read values are not saved
 	{
-	  input=IORD_ALTERA_AVALON_PIO_DATA(HEADERINPUTS_BASE); //Input pins state saved to input
+		return;
 	}
+	reading = READ_NONE;
 
-	timer = alt_timestamp_start();							//Start timer
+	slots_save(SV,CM_M,echo);				//Save the reading to the save slots that are on, CM or M
+}
+//###############################################################################################################################################
 
-	input=IORD_ALTERA_AVALON_PIO_DATA(HEADERINPUTS_BASE);	//Read input Pins
 
-	while(((input)&(0x01)) == 1 )							//While no input signal on input pin 1
-	{
-	  input=IORD_ALTERA_AVALON_PIO_DATA(HEADERINPUTS_BASE); //Read input Pins
-	}
+//Starts the first ping of a new reading's burst
+void reading_start(void)
+{
+	burst_begin();
+	ranger_start();
+	sched_wake(range_id,0);
+}
+//###############################################################################################################################################
 
-	timer = alt_timestamp();								//Save current timer value
 
-	float dis = timer*constant;								//Distance = Timer x Constant
+//Prints the statistics of the readings in the statistics window, distances in 0.01mm
+void stats_report(void)
+{
+	console_put_line("readings",(alt_u32)stats_count());
+	console_put_line("min 0.01mm",(alt_u32)convert_ticks(stats_min(),0,0));
+	console_put_line("max 0.01mm",(alt_u32)convert_ticks(stats_max(),0,0));
+	console_put_line("mean 0.01mm",(alt_u32)convert_ticks(stats_mean(),0,0));
+	console_put_line("deviation 0.01mm",(alt_u32)convert_ticks(stats_deviation(),0,0));
+	console_put_line("readings per 1000s",(alt_u32)stats_rate());
+}
+//###############################################################################################################################################
 
-	if(LED == 1)											//If LED setting is On
-	{
 
-		if(dis/1000 <= 1)										//If Distance/1000 <= 1
-		{
-			IOWR_ALTERA_AVALON_PIO_DATA(DE0_LEDS_BASE,0x000);	//NO LEDs are Lit
-		}
-		else if(dis/1000 <= 2)									//Else if Distance/1000 <= 2
-		{
-			IOWR_ALTERA_AVALON_PIO_DATA(DE0_LEDS_BASE,0x001);	//LED 0 is lit
-		}
-		else if(dis/1000 <= 3)									//Else if Distance/1000 <= 3
-		{
-			IOWR_ALTERA_AVALON_PIO_DATA(DE0_LEDS_BASE,0x003);	//LED 0:1 is lit
-		}
-		else if(dis/1000 <= 4)									//Else if Distance/1000 <= 4
-		{
-			IOWR_ALTERA_AVALON_PIO_DATA(DE0_LEDS_BASE,0x007);	//LED 0:2 is lit
-		}
-		else if(dis/1000 <= 5)									//Else if Distance/1000 <= 5
-		{
-			IOWR_ALTERA_AVALON_PIO_DATA(DE0_LEDS_BASE,0x00F);	//LED 0:3 is lit
-		}
-		else if(dis/1000 <= 6)									//Else if Distance/1000 <= 6
-		{
-			IOWR_ALTERA_AVALON_PIO_DATA(DE0_LEDS_BASE,0x01F);	//LED 0:4 is lit
-		}
-		else if(dis/1000 <= 7)									//Else if Distance/1000 <= 7
-		{
-			IOWR_ALTERA_AVALON_PIO_DATA(DE0_LEDS_BASE,0x03F);	//LED 0:5 is lit
-		}
-		else if(dis/1000 <= 8)									//Else if Distance/1000 <= 8
-		{
-			IOWR_ALTERA_AVALON_PIO_DATA(DE0_LEDS_BASE,0x07F);	//LED 0:6 is lit
-		}
-		else if(dis/1000 <= 9)									//Else if Distance/1000 <= 9
-		{
-			IOWR_ALTERA_AVALON_PIO_DATA(DE0_LEDS_BASE,0x0FF);	//LED 0:7 is lit
-		}
-		else if(dis/1000 < 10)									//Else if Distance/1000 < 10
-		{
-			IOWR_ALTERA_AVALON_PIO_DATA(DE0_LEDS_BASE,0xfff);	//LED 0:8 is lit
-		}
-	}
-	else
+//Returns the echo length of the shown sensor, or -1 if it failed, and sets time to when its echo started
+int sensor_echo(ranger_state state,alt_u64 *time)
+{
+	if(sensor < 0)											//Nearest sensor of the sweep
 	{
-		IOWR_ALTERA_AVALON_PIO_DATA(DE0_LEDS_BASE,0x000);		//All LEDs Off
+		*time = ranger_time();
+		return state == RANGER_DONE ? ranger_result() : -1;
 	}
-	return dis;													//return to line that called this function
+	*time = ranger_channel_time(sensor);
+	return ranger_channel_error(sensor) == RANGER_OK ? ranger_channel_result(sensor) : -1;
 }
+//###############################################################################################################################################
 
-//######################################################################################################################
 
-//Returns the hexidecimal value of supplied number for SSEG display
-int dig(int counter)
+//Shows the sensor typed before the command on the display, LEDs and statistics, or the nearest with no number
+void sensor_select(void)
 {
-    int digit;				//The Variable that will be returned
+	alt_32 value;
 
-	if (counter == 0)		//If supplied number is 0
-	{
-		digit = 0xC0;		//SSEG value for 0
-	}
-	else if(counter == 1)	//If supplied number is 1
-	{
-		digit = 0xF9;		//SSEG value for 1
-	}
-	else if(counter == 2)	//If supplied number is 2
-	{
-		digit = 0xA4;		//SSEG value for 2
-	}
-	else if(counter == 3)	//If supplied number is 3
-	{
-		digit = 0xB0;		//SSEG value for 3
-	}
-	else if(counter == 4)	//If supplied number is 4
+	if(!console_arg(&value))
 	{
-		digit = 0x99;		//SSEG value for 4
+		value = -1;											//No number, the nearest sensor
 	}
-	else if(counter == 5)	//If supplied number is 5
+	else if(value < 0 || value >= RANGER_CHANNELS)
 	{
-		digit = 0x92;		//SSEG value for 5
+		console_put("no such sensor\n");
+		return;
 	}
-	else if(counter == 6)	//If supplied number is 6
+	sensor = (int)value;
+	filter_reset();											//Readings of another sensor are a new series
+	track_reset();
+	if(sensor < 0)
 	{
-		digit = 0x82;		//SSEG value for 6
+		console_put("nearest sensor\n");
 	}
-	else if(counter == 7)	//If supplied number is 7
+	else
 	{
-		digit = 0xF8;		//SSEG value for 7
+		console_put_line("sensor",(alt_u32)sensor);
 	}
-	else if(counter == 8)	//If supplied number is 8
+}
+//###############################################################################################################################################
+
+
+//Returns the SSEG display word for an echo length in the supplied CM_M and DP settings, or the next format it fits in
+int display_word(int ticks,int CM_M,int DP)
+{
+	return autorange_fit(ticks,CM_M,DP);
+}
+//###############################################################################################################################################
+
+
+//Returns the SSEG display word for a save slot in the supplied CM_M and DP settings, blank if it is empty
+int slot_word(int slot,int CM_M,int DP)
+{
+	int ticks = slots_get(slot,CM_M);
+
+	if(ticks == SLOTS_EMPTY)
 	{
-		digit = 0x80;		//SSEG value for 8
+		return SSEG_BLANK_WORD;
 	}
-	else if(counter == 9)	//If supplied number is 9
+	return display_word(ticks,CM_M,DP);
+}
+//###############################################################################################################################################
+
+
+//This Function converts an echo length in ticks to a distance and updates the LEDs
+int distance_calc(int timer,int CM_M,int DP, int LED)
+{
+	int dis;
+	PROBE_BEGIN(PROBE_CONVERT);
+	dis = convert_ticks(timer,CM_M,DP);						//Distance = Timer x Constant, in fixed point
+	PROBE_END(PROBE_CONVERT);
+
+	if(LED == 1)											//If LED setting is On
 	{
-		digit = 0x98;		//SSEG value for 9
+		PROBE_BEGIN(PROBE_LEDS);
+		output_bargraph(dis);								//One LED per 1000 counts
+		PROBE_END(PROBE_LEDS);
 	}
 	else
 	{
-		digit = 0xC0;		//Else SSEG value for 0
+		output_leds_field(OUTPUT_BAR_LEDS,0x000);				//All bargraph LEDs Off
 	}
-	return digit;			//Return the hex value of the digit
+	return dis;													//return to line that called this function
 }
 
-//################################################################################################################
-
-//This function generates the display for the SSEG(7-segment) display
-int sseg(int distance, int DP)
-{
-	//These variable saves the individual digits
-	 int seg1 = dig(distance %10);			//Right most digit
-	 int seg2 = dig((distance/10)%10);		//Following digit
-	 int seg3 = dig((distance/100)%10);		//Following digit
-	 int seg4 = dig((distance/1000)%10);	//Last digit
-
-	 int sseg;								//the Variable that will be passed back to the line variable
-
-	 if(DP == 0)							//If Decimal point switch is Off
-	 {
-	 sseg = seg4 - 128;						//Add a decimal point to the Left most segment
-	 sseg = sseg << 8;						//shift over 8-bits
-	 sseg = sseg + seg3;					//Add the next digit
-	 }
-	 else
-	 {
-		 sseg = seg4;						//Else
-		 sseg = sseg << 8;
-		 seg3 = seg3 - 128;					//Decimal point is added to the next 7-segment display
-		 sseg = sseg + seg3;
-	 }
-
-	 sseg = sseg << 8;						//Shift over 8-bits
-	 sseg = sseg + seg2;					//Add Segment 2 so that it can be displayed
-	 sseg = sseg << 8;						//Shift over 8-bits
-	 sseg = sseg + seg1;					//Add final segment
-
-	return sseg;							//Return the entire display
-}
-//#########################################################################################################################
+//######################################################################################################################
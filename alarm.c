@@ -0,0 +1,207 @@
+/*
+ * 	Proximity alarm zones, see alarm.h.
+ *
+ * 	The thresholds are kept per sensor as raw echo lengths: a zone is entered by an echo shorter than enter
+ * 	and left by an echo at least release long. calib_generation() is compared on every call, so a new
+ * 	calibration or temperature moves the thresholds before the next echo is checked.
+ */
+
+#include "alarm.h"
+#include "convert.h"
+#include "output.h"
+#include "console.h"
+
+#define ALARM_MAX_MM		5000					//Longest zone, past the SRF05's range
+
+static int zone_mm[ALARM_ZONES];					//Distance of each zone, 0 when off
+static int enter[RANGER_CHANNELS][ALARM_ZONES];		//Echo lengths below which each zone turns on
+static int release[RANGER_CHANNELS][ALARM_ZONES];	//Echo lengths from which each zone turns off
+static alt_u32 active[RANGER_CHANNELS];				//Zones on for each sensor
+static alt_u32 zones = 0;							//Zones on for any sensor
+static int lead_mm = 0;								//Distance each zone reaches further for a closing target
+static alt_u32 generation = 0;						//calib_generation() the thresholds were worked out for
+
+//Works out the raw thresholds of every zone and sensor
+static void alarm_thresholds(void)
+{
+	int channel, zone;
+
+	for(zone = 0; zone < ALARM_ZONES; zone++)
+	{
+		int enter_ticks = zone_mm[zone] ? convert_limit(zone_mm[zone] + lead_mm, 1, 0) : 0;
+		int release_ticks = zone_mm[zone] ? convert_limit(zone_mm[zone] + lead_mm + ALARM_HYSTERESIS_MM, 1, 0) : 0;
+
+		for(channel = 0; channel < RANGER_CHANNELS; channel++)
+		{
+			enter[channel][zone] = enter_ticks ? calib_raw(channel, enter_ticks) : 0;
+			release[channel][zone] = release_ticks ? calib_raw(channel, release_ticks) : 0;
+		}
+	}
+	generation = calib_generation();
+}
+
+//Drives the header pins and LED from the zones on for any sensor
+static void alarm_output(void)
+{
+	alt_u32 now_on = 0;
+	int channel;
+
+	for(channel = 0; channel < RANGER_CHANNELS; channel++)
+	{
+		now_on |= active[channel];
+	}
+	if(now_on != zones)
+	{
+		output_header_set((int)((now_on & ~zones) << ALARM_HEADER_SHIFT));
+		output_header_clear((int)((zones & ~now_on) << ALARM_HEADER_SHIFT));
+		output_leds_field(ALARM_LED, now_on ? ALARM_LED : 0);
+		zones = now_on;
+	}
+}
+
+//Works out the thresholds again if the calibration has changed since
+static void alarm_check(void)
+{
+	if(generation != calib_generation())
+	{
+		alarm_thresholds();
+	}
+}
+
+//Sets the zones on for a sensor
+static void alarm_update(int channel, alt_u32 on)
+{
+	if(on != active[channel])
+	{
+		active[channel] = on;
+		alarm_output();
+	}
+}
+
+//Checks the zones of a sensor against an echo that has just ended
+void alarm_echo(int channel, int raw)
+{
+	alt_u32 on = active[channel];
+	int zone;
+
+	alarm_check();
+	for(zone = 0; zone < ALARM_ZONES; zone++)
+	{
+		if(raw < enter[channel][zone])
+		{
+			on |= 1u << zone;
+		}
+		else if(raw >= release[channel][zone])
+		{
+			on &= ~(1u << zone);
+		}
+	}
+	alarm_update(channel, on);
+}
+
+//Turns off the zones of a sensor that an echo still high has already passed
+void alarm_high(int channel, int elapsed)
+{
+	alt_u32 on = active[channel];
+	int zone;
+
+	alarm_check();
+	for(zone = 0; zone < ALARM_ZONES; zone++)
+	{
+		if(elapsed >= release[channel][zone])
+		{
+			on &= ~(1u << zone);
+		}
+	}
+	alarm_update(channel, on);
+}
+
+//Returns the raw echo length past which the next zone of a sensor turns off, 0 if no zone is on
+int alarm_release(int channel)
+{
+	int next = 0;
+	int zone;
+
+	alarm_check();
+	for(zone = 0; zone < ALARM_ZONES; zone++)
+	{
+		if((active[channel] >> zone) & 1 && (next == 0 || release[channel][zone] < next))
+		{
+			next = release[channel][zone];
+		}
+	}
+	return next;
+}
+
+//Gives the zones the lead of a target closing in at mm_s, none when it is not closing in
+void alarm_approach(alt_32 mm_s)
+{
+	int lead = mm_s > 0 ? (int)((alt_64)mm_s * ALARM_LEAD_MS / 1000) : 0;
+
+	lead = lead > ALARM_MAX_LEAD_MM ? ALARM_MAX_LEAD_MM : lead;
+	if(lead != lead_mm)
+	{
+		lead_mm = lead;
+		alarm_thresholds();
+	}
+}
+
+//Returns the mask of the zones that are on
+alt_u32 alarm_zones(void)
+{
+	return zones;
+}
+
+//Sets the distance of a zone from the number typed before the command
+static void alarm_set(int zone)
+{
+	alt_32 mm;
+	int channel;
+
+	if(!console_arg(&mm) || mm < 0 || mm > ALARM_MAX_MM)
+	{
+		console_put("type the distance in mm before the command, 0 for off\n");
+		return;
+	}
+	zone_mm[zone] = (int)mm;
+	store_set(ALARM_KEY + zone, (alt_u32)mm);
+	alarm_thresholds();
+	if(mm == 0)
+	{
+		for(channel = 0; channel < RANGER_CHANNELS; channel++)
+		{
+			active[channel] &= ~(1u << zone);
+		}
+		alarm_output();
+	}
+	console_put_line("zone", zone);
+	console_put_line("mm", (alt_u32)mm);
+}
+
+//Sets the distance of zone 0
+static void alarm_zone0(void)
+{
+	alarm_set(0);
+}
+
+//Sets the distance of zone 1
+static void alarm_zone1(void)
+{
+	alarm_set(1);
+}
+
+//Restores the zones and adds the console commands
+void alarm_init(void)
+{
+	alt_u32 value;
+	int zone;
+
+	for(zone = 0; zone < ALARM_ZONES; zone++)
+	{
+		zone_mm[zone] = store_get(ALARM_KEY + zone, &value) && value <= ALARM_MAX_MM ? (int)value : 0;
+	}
+	alarm_thresholds();
+
+	console_add('z', alarm_zone0, "<mm>z set alarm zone 0, 0 for off");
+	console_add('Z', alarm_zone1, "<mm>Z set alarm zone 1, 0 for off");
+}
@@ -0,0 +1,56 @@
+/*
+ * 	Proximity alarm zones, checked in the tick domain as the echo is timed.
+ *
+ * 	Each zone has a distance in mm and turns on when a sensor's echo ends shorter than that distance, and off
+ * 	again once an echo is ALARM_HYSTERESIS_MM longer, so a target sat on the edge does not chatter. Both
+ * 	distances are worked out once as raw echo lengths for every sensor(the inverse of its calibration, calib.h),
+ * 	and only again when a zone or the calibration changes, so a check is one compare with no conversion.
+ *
+ * 	The ranger calls alarm_echo() the moment it sees an echo end, before the result is corrected or converted,
+ * 	so a zone turns on within one poll(or one edge interrupt) of the echo falling. While an echo is still high
+ * 	its next release length is one of the ranger's deadlines, and alarm_high() turns a zone off as soon as the
+ * 	echo has been high for longer, without waiting for the echo to end.
+ *
+ * 	In constant read each zone reaches further by the distance the tracked target closes in ALARM_LEAD_MS
+ * 	(alarm_approach(), from track_approach()), so a target coming in fast sets the alarm off that much sooner.
+ * 	A target standing or moving away gets no lead, and the lead is at most ALARM_MAX_LEAD_MM.
+ *
+ * 	Zone n drives header output pin ALARM_HEADER_SHIFT + n, above the trigger pins, and ALARM_LED is lit
+ * 	while any zone is on. A zone is on while it is on for any sensor. Zone distances are kept in store.c.
+ *
+ *	<Console Commands>
+ *	<mm>z	//Sets the distance of zone 0, 0 turns it off
+ *	<mm>Z	//Sets the distance of zone 1, 0 turns it off
+ *	<END>>>
+ */
+
+#ifndef ALARM_H_
+#define ALARM_H_
+
+#include "ranger.h"
+#include "calib.h"
+#include "store.h"
+
+#define ALARM_ZONES			2						//Number of zones
+#define ALARM_HYSTERESIS_MM	20						//Extra distance before a zone turns off
+#define ALARM_LEAD_MS		200						//Time ahead a closing target sets a zone off
+#define ALARM_MAX_LEAD_MM	500						//Longest lead
+#define ALARM_HEADER_SHIFT	8						//Header output pin of zone 0, the pins below are triggers
+#define ALARM_LED			0x200					//LED 9, lit while any zone is on
+#define ALARM_KEY			(STORE_KEYS - ALARM_ZONES)	//First store.c key, the distance of each zone
+
+#if RANGER_CHANNELS > ALARM_HEADER_SHIFT
+#error "Alarm header pins overlap the sensor triggers"
+#endif
+#if CALIB_KEY + 1 + 2 * RANGER_CHANNELS > ALARM_KEY
+#error "Not enough store keys for the alarm zones"
+#endif
+
+void alarm_init(void);								//Restores the zones and adds the console commands
+void alarm_echo(int channel, int raw);				//Checks the zones against an echo that has just ended
+void alarm_high(int channel, int elapsed);			//Turns off the zones an echo still high has passed
+int alarm_release(int channel);						//Raw echo length past which a zone of a sensor turns off, 0 if none is on
+void alarm_approach(alt_32 mm_s);					//Gives the zones the lead of a target closing in at mm_s
+alt_u32 alarm_zones(void);							//Mask of the zones that are on
+
+#endif /* ALARM_H_ */
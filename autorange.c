@@ -0,0 +1,73 @@
+/*
+ * 	Auto-ranging SSEG display, see autorange.h.
+ */
+
+#include "autorange.h"
+#include "convert.h"
+#include "sseg.h"
+
+static int limit[AUTORANGE_FORMATS];			//Shortest echo that does not fit in each format
+static int back[AUTORANGE_FORMATS];				//Echoes shorter than this move back to the format
+static int current = 0;							//Format of the last live reading
+
+//Works out the thresholds for each format
+void autorange_init(void)
+{
+	int format;
+
+	for(format = 0; format < AUTORANGE_FORMATS; format++)
+	{
+		limit[format] = convert_limit(AUTORANGE_LIMIT, format >> 1, format & 1);
+		back[format] = convert_limit(AUTORANGE_LIMIT - AUTORANGE_HYSTERESIS, format >> 1, format & 1);
+	}
+}
+
+//Returns the display word for ticks in a format, or Err if it does not fit in any format of the unit
+static int autorange_render(int ticks, int format, int end)
+{
+	if(format >= end)
+	{
+		return SSEG_ERR;
+	}
+	return sseg(convert_ticks(ticks, format >> 1, format & 1), format & 1);
+}
+
+//Returns the display word for a live reading, staying in a longer range format until the reading is well below its limit
+int autorange_word(int ticks, int CM_M, int DP)
+{
+	int preferred = ((CM_M & 1) << 1) | (DP & 1);	//Format set by the switches
+	int end = AUTORANGE_UNIT_END(CM_M);				//Formats past this change the unit
+
+	if(current < preferred || current >= end)		//Unit changed since the last reading
+	{
+		current = preferred;
+	}
+	while(current > preferred && ticks < back[current - 1])	//Move back towards the switch format
+	{
+		current--;
+	}
+	while(current < end && ticks >= limit[current])					//Move on until it fits
+	{
+		current++;
+	}
+
+	if(current >= end)
+	{
+		current = preferred;
+		return SSEG_ERR;
+	}
+	return autorange_render(ticks, current, end);
+}
+
+//Returns the display word for a single value in the first format of the unit from the switch format that fits
+int autorange_fit(int ticks, int CM_M, int DP)
+{
+	int format = ((CM_M & 1) << 1) | (DP & 1);
+	int end = AUTORANGE_UNIT_END(CM_M);
+
+	while(format < end && ticks >= limit[format])
+	{
+		format++;
+	}
+	return autorange_render(ticks, format, end);
+}
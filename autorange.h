@@ -0,0 +1,31 @@
+/*
+ * 	Auto-ranging SSEG display.
+ *
+ * 	The four display formats set by the CM_M and DP switches each cover ten times the range of the one
+ * 	before, see convert.h. The format set by the switches is always used when the reading fits in it.
+ * 	When it does not, the format of the same unit with the decimal point one place to the right is used
+ * 	instead, so readings past the DP switch's range are shown instead of Err. The unit is never changed, as
+ * 	the display has no digit spare to show it: 1234mm in CM mode would read 1.234 exactly like 1.234cm.
+ * 	A reading past 999.9mm in CM mode therefore still shows Err.
+ *
+ * 	The format is chosen by comparing the echo length in ticks with thresholds worked out once by
+ * 	autorange_init(), so choosing it adds no divisions. Once a reading has moved to a longer range format,
+ * 	later readings only move back when they are AUTORANGE_HYSTERESIS below the limit, so a reading close
+ * 	to a limit does not make the display flicker between formats.
+ */
+
+#ifndef AUTORANGE_H_
+#define AUTORANGE_H_
+
+#include "hal.h"
+
+#define AUTORANGE_FORMATS		4				//Format n is CM_M = n >> 1, DP = n & 1
+#define AUTORANGE_UNIT_END(CM_M)	((((CM_M) & 1) << 1) + 2)	//First format past the CM_M switch's unit
+#define AUTORANGE_LIMIT			10000			//First value that does not fit on the display
+#define AUTORANGE_HYSTERESIS	(AUTORANGE_LIMIT / 20)	//Values a reading must be below the limit to move back
+
+void autorange_init(void);						//Works out the thresholds for each format
+int autorange_word(int ticks, int CM_M, int DP);	//Display word for a live reading, with hysteresis
+int autorange_fit(int ticks, int CM_M, int DP);	//Display word for a single value, such as a saved one
+
+#endif /* AUTORANGE_H_ */
@@ -0,0 +1,139 @@
+/*
+ * 	Oversampling bursts, see burst.h.
+ */
+
+#include "burst.h"
+#include "cadence.h"
+#include "console.h"
+
+static const char *const method_names[BURST_METHODS] =
+{
+	"mean",
+	"median",
+	"trimmed mean"
+};
+
+static int size = 1;							//Pings per burst
+static burst_method method = BURST_MEDIAN;		//How the echoes are combined
+static int echoes[BURST_MAX];					//Echoes of the pings that succeeded, sorted for the median
+static int count = 0;							//Echoes collected
+static int pings = 0;							//Pings made, including failed ones
+static alt_u64 started = 0;						//Time the burst started
+static alt_u64 first_echo = 0;						//Time the first echo of the burst started
+static alt_u64 last_echo = 0;						//Time the last echo of the burst started
+static alt_u64 latency = 0;						//Length of the last burst
+
+//Sets the burst size and method
+void burst_config(int new_size, burst_method new_method)
+{
+	size = new_size < 1 ? 1 : (new_size > BURST_MAX ? BURST_MAX : new_size);
+	method = new_method < BURST_METHODS ? new_method : BURST_MEAN;
+}
+
+//Starts a new burst
+void burst_begin(void)
+{
+	count = 0;
+	pings = 0;
+	started = timebase_now();
+}
+
+//Adds a ping's echo started at time, keeping the echoes in order, and returns 1 while more pings are needed
+int burst_add(alt_u64 time, int ticks)
+{
+	int i;
+
+	pings++;
+	if(ticks >= 0)
+	{
+		if(count == 0)
+		{
+			first_echo = time;
+		}
+		last_echo = time;
+		for(i = count; i > 0 && echoes[i - 1] > ticks; i--)		//Insertion sort
+		{
+			echoes[i] = echoes[i - 1];
+		}
+		echoes[i] = ticks;
+		count++;
+	}
+	if(pings < size)
+	{
+		return 1;
+	}
+	latency = timebase_elapsed(started);
+	return 0;
+}
+
+//Returns the combined echo of the burst, -1 if every ping failed
+int burst_result(void)
+{
+	alt_u64 sum = 0;
+	int first = 0;
+	int last = count;
+	int i;
+
+	if(count == 0)
+	{
+		return -1;
+	}
+	if(method == BURST_MEDIAN)
+	{
+		return (count & 1) ? echoes[count >> 1] : (echoes[(count >> 1) - 1] + echoes[count >> 1] + 1) >> 1;
+	}
+	if(method == BURST_TRIMMED)					//Drop the lowest and highest quarter
+	{
+		first = count >> 2;
+		last = count - first;
+	}
+	for(i = first; i < last; i++)
+	{
+		sum += (alt_u32)echoes[i];
+	}
+	return (int)((sum + ((last - first) >> 1)) / (alt_u32)(last - first));
+}
+
+//Returns the time the combined echo stands for, half way between the first and last echoes of the burst
+alt_u64 burst_time(void)
+{
+	return first_echo + ((last_echo - first_echo) >> 1);
+}
+
+//Returns the ticks from the start to the end of the last burst
+alt_u64 burst_latency(void)
+{
+	return latency;
+}
+
+//Steps the burst size through 1, 2, 4, 8 and 16
+static void burst_next_size(void)
+{
+	burst_config(size >= BURST_MAX ? 1 : size << 1, method);
+	console_put_line("burst size", size);
+}
+
+//Steps through the methods
+static void burst_next_method(void)
+{
+	burst_config(size, (burst_method)((method + 1) % BURST_METHODS));
+	console_put("burst method ");
+	console_put(method_names[method]);
+	console_put("\n");
+}
+
+//Reports the ping rate and burst latency
+static void burst_report(void)
+{
+	console_put_line("burst size", size);
+	console_put_line("pings per 1000s", cadence_rate());
+	console_put_line("last burst us", (alt_u32)TIMING_TO_US(latency));
+}
+
+//Adds the console commands
+void burst_init(void)
+{
+	console_add('n', burst_next_size, "burst size 1/2/4/8/16");
+	console_add('a', burst_next_method, "burst method mean/median/trimmed");
+	console_add('r', burst_report, "ping rate and burst latency");
+}
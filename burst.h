@@ -0,0 +1,42 @@
+/*
+ * 	Oversampling bursts.
+ *
+ * 	Each displayed or saved value can be made from a burst of up to BURST_MAX pings, fired one after the
+ * 	other as fast as cadence.c allows. The echoes of the pings that succeed are combined by the selected
+ * 	method into one value. A burst of 1(the default) gives each ping its own value, as before.
+ *
+ * 	The burst size and method are changed at run time from the console:
+ * 	'n' steps the size through 1, 2, 4, 8 and 16, 'a' steps the method and 'r' reports the achieved ping rate
+ * 	and how long the last burst took, so latency can be traded for precision.
+ *
+ *	<Methods>
+ *	BURST_MEAN		//Mean of every echo
+ *	BURST_MEDIAN	//Middle echo, ignores a minority of spurious echoes
+ *	BURST_TRIMMED	//Mean of the middle half of the echoes
+ *	<END>>>
+ */
+
+#ifndef BURST_H_
+#define BURST_H_
+
+#include "timebase.h"
+
+#define BURST_MAX		16						//Largest burst
+
+typedef enum
+{
+	BURST_MEAN,
+	BURST_MEDIAN,
+	BURST_TRIMMED,
+	BURST_METHODS								//Number of methods
+} burst_method;
+
+void burst_init(void);							//Adds the console commands
+void burst_config(int size, burst_method method);	//Sets the burst size and method
+void burst_begin(void);							//Starts a new burst
+int burst_add(alt_u64 time, int ticks);			//Adds a ping's echo started at time, -1 if it failed, returns 1 while more pings are needed
+int burst_result(void);							//Combined echo of the burst, -1 if every ping failed
+alt_u64 burst_time(void);						//Time the combined echo stands for, half way between the first and last echoes
+alt_u64 burst_latency(void);					//Ticks from the start to the end of the last burst
+
+#endif /* BURST_H_ */
@@ -0,0 +1,119 @@
+/*
+ * 	Adaptive ping cadence for the SRF05, see cadence.h.
+ */
+
+#include "cadence.h"
+#include "console.h"
+
+static alt_u64 recovery = CADENCE_RECOVERY;		//Quiet time needed after an echo ends
+static int rate = CADENCE_MAX_RATE;				//Maximum triggers per second, 0 for no limit
+static alt_u64 period = TIMING_HZ / CADENCE_MAX_RATE;	//Minimum time between triggers
+
+static alt_u64 last_trigger = 0;				//Time of the last trigger, 0 if none
+static alt_u64 last_echo = 0;					//Time the last echo ended, 0 if none
+
+static alt_u64 first_trigger = 0;				//Time of the first trigger since the last reset
+static alt_u32 triggers = 0;					//Triggers since the last reset
+
+//Sets the recovery hold off and maximum rate
+void cadence_config(alt_u64 new_recovery, int max_rate)
+{
+	recovery = new_recovery;
+	rate = max_rate > 0 ? max_rate : 0;
+	period = rate ? TIMING_HZ / rate : 0;
+}
+
+//Returns the earliest time the next trigger is allowed
+alt_u64 cadence_next(void)
+{
+	alt_u64 next = 0;
+
+	if(last_echo)
+	{
+		next = last_echo + recovery;			//Let late reflections die out
+	}
+	if(last_trigger && last_trigger + period > next)
+	{
+		next = last_trigger + period;			//Keep to the maximum rate
+	}
+	return next;
+}
+
+//Records that a trigger was sent at time
+void cadence_trigger(alt_u64 time)
+{
+	if(triggers == 0)
+	{
+		first_trigger = time;
+	}
+	triggers++;
+	last_trigger = time;
+}
+
+//Records that the echo ended at time
+void cadence_echo_end(alt_u64 time)
+{
+	last_echo = time;
+}
+
+//Returns the achieved triggers per 1000 seconds since the last reset
+int cadence_rate(void)
+{
+	alt_u64 span = last_trigger - first_trigger;
+
+	if(triggers < 2 || span == 0)
+	{
+		return 0;
+	}
+	return (int)((alt_u64)(triggers - 1) * TIMING_HZ * 1000 / span);
+}
+
+//Restarts the achieved rate count
+void cadence_reset(void)
+{
+	triggers = 0;
+}
+
+//Prints the settings and the rate achieved with the last ones, then starts a new count for the new ones
+static void cadence_report(void)
+{
+	console_put_line("hold off us", (alt_u32)TIMING_TO_US(recovery));
+	console_put_line("max rate", rate);
+	console_put_line("pings per 1000s", cadence_rate());
+	cadence_reset();
+}
+
+//Sets the recovery hold off from the number typed before the command
+static void cadence_holdoff(void)
+{
+	alt_32 us;
+
+	if(!console_arg(&us) || us < 0 || us > CADENCE_MAX_RECOVERY_US)
+	{
+		console_put("type the hold off in us before the command\n");
+		return;
+	}
+	cadence_config(TIMING_US((alt_u64)us), rate);
+	cadence_report();
+}
+
+//Sets the maximum rate from the number typed before the command
+static void cadence_max_rate(void)
+{
+	alt_32 max_rate;
+
+	if(!console_arg(&max_rate) || max_rate < 0 || max_rate > CADENCE_TOP_RATE)
+	{
+		console_put("type the triggers per second before the command, 0 for no limit\n");
+		return;
+	}
+	cadence_config(recovery, (int)max_rate);
+	cadence_report();
+}
+
+//Adds the console commands
+void cadence_init(void)
+{
+	console_add('h', cadence_holdoff, "<us>h set the ping recovery hold off");
+	console_add('m', cadence_max_rate, "<n>m set the max pings per second, 0 for no limit");
+}
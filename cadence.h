@@ -0,0 +1,39 @@
+/*
+ * 	Adaptive ping cadence for the SRF05.
+ *
+ * 	Instead of always waiting 50ms before a trigger, the next trigger is allowed as soon as the last echo
+ * 	has ended plus a recovery hold off, so late reflections have died out, but no sooner than the minimum
+ * 	period set by the maximum rate. Near targets give short echoes and so get a higher update rate.
+ * 	Both can be changed from the console to find the fastest cadence a room allows without ghost echoes,
+ * 	each change prints the settings with the rate achieved since the last one.
+ *
+ *	<Console Commands>
+ *	<us>h	//Sets the recovery hold off after an echo ends
+ *	<n>m	//Sets the maximum triggers per second, 0 for no limit
+ *	<END>>>
+ */
+
+#ifndef CADENCE_H_
+#define CADENCE_H_
+
+#include "timebase.h"
+
+#ifndef CADENCE_RECOVERY
+#define CADENCE_RECOVERY	TIMEBASE_MS(10)		//Quiet time needed after an echo ends
+#endif
+#ifndef CADENCE_MAX_RATE
+#define CADENCE_MAX_RATE	100					//Maximum triggers per second
+#endif
+
+#define CADENCE_MAX_RECOVERY_US	1000000			//Longest recovery hold off the console accepts
+#define CADENCE_TOP_RATE	1000				//Highest maximum rate the console accepts
+
+void cadence_init(void);						//Adds the console commands
+void cadence_config(alt_u64 recovery, int max_rate);	//Sets the recovery hold off and maximum rate
+alt_u64 cadence_next(void);						//Earliest time the next trigger is allowed
+void cadence_trigger(alt_u64 time);				//Records that a trigger was sent at time
+void cadence_echo_end(alt_u64 time);			//Records that the echo ended at time
+int cadence_rate(void);							//Achieved triggers per 1000 seconds since the last reset
+void cadence_reset(void);						//Restarts the achieved rate count
+
+#endif /* CADENCE_H_ */
@@ -0,0 +1,254 @@
+/*
+ * 	Per sensor calibration, see calib.h.
+ *
+ * 	A fit gives the echo length of a sensor as t = a + b x mm, by least squares in 64-bit integers.
+ * 	The offset is a, and the gain is the ticks per mm a perfect sensor gives at the speed of sound the points
+ * 	were measured at over b. The gain saved is therefore the sensor's own, the temperature only ever enters
+ * 	through the factor.
+ */
+
+#include "calib.h"
+#include "console.h"
+
+#define CALIB_NO_TEMP	0x80000000u					//Saved temperature when none is set
+#define CALIB_MIN_GAIN	(CALIB_ONE / 2)				//A fit outside 0.5 to 2 is a measuring mistake
+#define CALIB_MAX_GAIN	(CALIB_ONE * 2)
+
+static int offset[RANGER_CHANNELS];					//Ticks of delay of each sensor
+static alt_u32 gain[RANGER_CHANNELS];				//Gain of each sensor at the nominal speed of sound, Q16
+static alt_u32 factor[RANGER_CHANNELS];				//Gain x speed of sound / nominal speed of sound, Q16
+static alt_u32 speed = SOUND_SPEED_MM_S;			//Speed of sound at the set temperature, mm/s
+static alt_u32 generation = 0;						//Count of calib_fold() calls
+
+static int point_mm[CALIB_POINTS];					//Known distance of each point
+static int point_ticks[CALIB_POINTS][RANGER_CHANNELS];	//Mean raw echo length of each sensor, 0 if it failed
+static int point_count = 0;
+static alt_u64 sum[RANGER_CHANNELS];				//Point being measured
+static int sum_count[RANGER_CHANNELS];
+static int offered = 0;								//Readings offered to the point being measured
+static int sampling = 0;
+
+//Returns the speed of sound in mm/s at a temperature in tenths of a degree C
+static alt_u32 calib_speed(alt_32 tenths)
+{
+	return (alt_u32)(331300 + 606 * tenths / 10);	//331.3m/s + 0.606m/s per degree
+}
+
+//Folds the gain and speed of sound of every sensor into its factor
+static void calib_fold(void)
+{
+	int channel;
+
+	for(channel = 0; channel < RANGER_CHANNELS; channel++)
+	{
+		factor[channel] = (alt_u32)(((alt_u64)gain[channel] * speed + SOUND_SPEED_MM_S / 2) / SOUND_SPEED_MM_S);
+	}
+	generation++;
+}
+
+//Saves the calibration of one sensor
+static void calib_save(int channel)
+{
+	store_set(CALIB_KEY + 1 + 2 * channel, (alt_u32)offset[channel]);
+	store_set(CALIB_KEY + 2 + 2 * channel, gain[channel]);
+}
+
+//Corrects a raw echo length of a sensor to nominal ticks
+int calib_ticks(int channel, int ticks)
+{
+	alt_64 delay = (alt_64)ticks - offset[channel];
+
+	if(delay <= 0)
+	{
+		return 0;
+	}
+	return (int)((delay * factor[channel]) >> 16);
+}
+
+//Returns the raw echo length of a sensor that corrects to nominal ticks, for thresholds worked out in advance
+int calib_raw(int channel, int ticks)
+{
+	alt_u64 delay = (((alt_u64)(alt_u32)ticks << 16) + factor[channel] - 1) / factor[channel];	//Rounded up
+
+	return (int)(delay + offset[channel]);
+}
+
+//Returns a count that changes whenever a factor or offset changes, so thresholds can be worked out again
+alt_u32 calib_generation(void)
+{
+	return generation;
+}
+
+//Returns 1 while a point is being measured
+int calib_sampling(void)
+{
+	return sampling;
+}
+
+//Adds a raw echo length of a sensor to the point being measured, ticks <= 0 if the sensor failed
+void calib_sample(int channel, int ticks)
+{
+	int i;
+
+	if(!sampling)
+	{
+		return;
+	}
+	if(ticks > 0)
+	{
+		sum[channel] += (alt_u32)ticks;
+		sum_count[channel]++;
+	}
+	if(channel < RANGER_CHANNELS - 1 || ++offered < CALIB_SAMPLES)
+	{
+		return;
+	}
+
+	for(i = 0; i < RANGER_CHANNELS; i++)			//Point finished, sensors that mostly failed are left out
+	{
+		point_ticks[point_count][i] = sum_count[i] >= CALIB_SAMPLES / 2 ? (int)(sum[i] / sum_count[i]) : 0;
+	}
+	point_count++;
+	sampling = 0;
+	console_put_line("point done", point_count);
+}
+
+//Starts measuring a point at the distance typed before the command
+static void calib_point(void)
+{
+	alt_32 mm;
+	int channel;
+
+	if(!console_arg(&mm) || mm <= 0)
+	{
+		console_put("type the distance in mm before c\n");
+		return;
+	}
+	if(point_count >= CALIB_POINTS)
+	{
+		console_put("points full, fit with C\n");
+		return;
+	}
+	for(channel = 0; channel < RANGER_CHANNELS; channel++)
+	{
+		sum[channel] = 0;
+		sum_count[channel] = 0;
+	}
+	point_mm[point_count] = (int)mm;
+	offered = 0;
+	sampling = 1;
+	console_put_line("measuring mm", (alt_u32)mm);
+}
+
+//Fits the offset and gain of each sensor from its points, returns 0 if it does not have two distances
+static int calib_fit(int channel)
+{
+	alt_64 n = 0, sd = 0, st = 0, sdd = 0, sdt = 0;
+	alt_64 num, den;
+	alt_64 fit_gain;
+	int i;
+
+	for(i = 0; i < point_count; i++)
+	{
+		if(point_ticks[i][channel] > 0)
+		{
+			n++;
+			sd += point_mm[i];
+			st += point_ticks[i][channel];
+			sdd += (alt_64)point_mm[i] * point_mm[i];
+			sdt += (alt_64)point_mm[i] * point_ticks[i][channel];
+		}
+	}
+	den = n * sdd - sd * sd;						//Slope b = num / den ticks per mm
+	num = n * sdt - sd * st;
+	if(n < 2 || den <= 0 || num <= 0)
+	{
+		return 0;
+	}
+
+	fit_gain = (alt_64)((((alt_u64)TIMING_HZ * 2) << 16) / speed) * den / num;	//Ticks per mm of a perfect sensor at the set speed, Q16, over b
+	if(fit_gain < CALIB_MIN_GAIN || fit_gain > CALIB_MAX_GAIN)
+	{
+		return 0;
+	}
+	offset[channel] = (int)((st * den - num * sd) / (n * den));	//a = (st - b x sd) / n
+	gain[channel] = (alt_u32)fit_gain;
+	return 1;
+}
+
+//Fits every sensor, saves the result and clears the points
+static void calib_fit_all(void)
+{
+	int channel;
+
+	for(channel = 0; channel < RANGER_CHANNELS; channel++)
+	{
+		console_put_line("sensor", channel);
+		if(!calib_fit(channel))
+		{
+			console_put("not enough points\n");
+			continue;
+		}
+		calib_save(channel);
+		console_put("offset ");
+		console_put_i32(offset[channel]);
+		console_put_line("\ngain ppm", (alt_u32)(((alt_u64)gain[channel] * 1000000) >> 16));
+	}
+	calib_fold();
+	point_count = 0;
+	sampling = 0;
+}
+
+//Clears the calibration of every sensor
+static void calib_clear(void)
+{
+	int channel;
+
+	for(channel = 0; channel < RANGER_CHANNELS; channel++)
+	{
+		offset[channel] = 0;
+		gain[channel] = CALIB_ONE;
+		calib_save(channel);
+	}
+	calib_fold();
+	console_put("calibration cleared\n");
+}
+
+//Sets the air temperature typed before the command, in tenths of a degree C
+static void calib_temperature(void)
+{
+	alt_32 tenths;
+
+	if(console_arg(&tenths))
+	{
+		speed = calib_speed(tenths);
+		store_set(CALIB_KEY, (alt_u32)tenths);
+	}
+	else
+	{
+		speed = SOUND_SPEED_MM_S;
+		store_set(CALIB_KEY, CALIB_NO_TEMP);
+	}
+	calib_fold();
+	console_put_line("speed mm/s", speed);
+}
+
+//Restores the calibration and adds the console commands
+void calib_init(void)
+{
+	alt_u32 value;
+	int channel;
+
+	for(channel = 0; channel < RANGER_CHANNELS; channel++)
+	{
+		offset[channel] = store_get(CALIB_KEY + 1 + 2 * channel, &value) ? (int)value : 0;
+		gain[channel] = store_get(CALIB_KEY + 2 + 2 * channel, &value) ? value : CALIB_ONE;
+	}
+	speed = store_get(CALIB_KEY, &value) && value != CALIB_NO_TEMP ? calib_speed((alt_32)value) : SOUND_SPEED_MM_S;
+	calib_fold();
+
+	console_add('c', calib_point, "<mm>c measure a calibration point");
+	console_add('C', calib_fit_all, "fit and save the calibration");
+	console_add('u', calib_clear, "clear the calibration");
+	console_add('T', calib_temperature, "<tenths C>T set the air temperature");
+}
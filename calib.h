@@ -0,0 +1,47 @@
+/*
+ * 	Per sensor calibration, applied to the echo length in the tick domain.
+ *
+ * 	Each sensor has an offset(ticks of delay in the sensor and wiring) and a gain, learned by fitting a line
+ * 	through the echo lengths measured at two or more known distances. The air temperature changes the
+ * 	speed of sound by about 0.18% per degree, so the temperature the fit was made at is kept and a new
+ * 	temperature can be entered at any time.
+ *
+ * 	Gain and temperature are folded into one Q16 factor per sensor whenever either changes, so correcting a
+ * 	reading is a subtract and a multiply. The corrected echo is in nominal ticks, the echo length a perfect
+ * 	sensor gives at SOUND_SPEED_MM_S, so everything after the ranger(conversion, display, slots, filters)
+ * 	is unchanged. An uncalibrated sensor with no temperature set has a factor of exactly 1.
+ *
+ * 	Calibration is kept in store.c and so survives a power cycle.
+ *
+ *	<Console Commands>
+ *	<mm>c	//Averages the next CALIB_SAMPLES readings of every sensor as a point at mm, needs a reading running
+ *	C		//Fits the points of each sensor with two or more distances, saves the result and clears the points
+ *	u		//Clears the calibration of every sensor
+ *	<t>T	//Sets the air temperature in tenths of a degree C, T alone goes back to the nominal speed of sound
+ *	<END>>>
+ */
+
+#ifndef CALIB_H_
+#define CALIB_H_
+
+#include "ranger.h"
+#include "convert.h"
+#include "store.h"
+
+#define CALIB_POINTS	8							//Known distances per fit
+#define CALIB_SAMPLES	16							//Readings averaged per point
+#define CALIB_ONE		65536						//Gain and factor of 1, Q16
+#define CALIB_KEY		10							//First store.c key: temperature, then offset and gain of each sensor
+
+#if CALIB_KEY + 1 + 2 * RANGER_CHANNELS > STORE_KEYS
+#error "Not enough store keys for the calibration of every sensor"
+#endif
+
+void calib_init(void);								//Restores the calibration and adds the console commands
+int calib_ticks(int channel, int ticks);			//Corrects a raw echo length of a sensor to nominal ticks
+int calib_raw(int channel, int ticks);				//Raw echo length of a sensor that corrects to nominal ticks
+alt_u32 calib_generation(void);						//Changes whenever a factor or offset changes
+int calib_sampling(void);							//1 while a point is being measured
+void calib_sample(int channel, int ticks);			//Adds a raw echo length to the point being measured
+
+#endif /* CALIB_H_ */
@@ -0,0 +1,165 @@
+/*
+ * 	Single letter commands on the JTAG UART console, see console.h.
+ */
+
+#include "console.h"
+#include "sched.h"
+#include "telemetry.h"
+
+typedef struct
+{
+	char key;								//Letter that runs the command
+	console_fn fn;
+	const char *help;						//Shown by '?'
+} console_command;
+
+static console_command commands[CONSOLE_COMMANDS];
+static int command_count = 0;
+static alt_32 arg = 0;						//Number typed before the command
+static int arg_digits = 0;					//Digits in arg, 0 if none was typed
+static int arg_negative = 0;				//1 if arg started with '-'
+
+//Writes a string once any telemetry frame part way out has been sent
+void console_put(const char *str)
+{
+	telemetry_finish();
+	hal_putstr(str);
+}
+
+//Writes a number in decimal
+void console_put_u32(alt_u32 value)
+{
+	char text[11];
+	int pos = sizeof(text) - 1;
+
+	text[pos] = 0;
+	do
+	{
+		text[--pos] = (char)('0' + value % 10);
+		value /= 10;
+	} while(value);
+	console_put(&text[pos]);
+}
+
+//Writes a signed number in decimal
+void console_put_i32(alt_32 value)
+{
+	if(value < 0)
+	{
+		console_put("-");
+		console_put_u32((alt_u32)0 - (alt_u32)value);
+		return;
+	}
+	console_put_u32((alt_u32)value);
+}
+
+//Copies the number typed before the command, returns 0 if there was none
+int console_arg(alt_32 *value)
+{
+	*value = arg_negative ? -arg : arg;
+	return arg_digits > 0;
+}
+
+//Writes "label value" on its own line
+void console_put_line(const char *label, alt_u32 value)
+{
+	console_put(label);
+	console_put(" ");
+	console_put_u32(value);
+	console_put("\n");
+}
+
+//Lists the commands
+static void console_help(void)
+{
+	char key[4] = {' ', 0, ' ', 0};
+	int i;
+
+	for(i = 0; i < command_count; i++)
+	{
+		key[1] = commands[i].key;
+		console_put(key);
+		console_put(commands[i].help);
+		console_put("\n");
+	}
+}
+
+#ifdef HAL_CONSOLE
+
+static int task = -1;						//Scheduler task id
+
+//Runs the command for every letter typed since the last check
+static void console_task(void)
+{
+	int c;
+	int i;
+
+	sched_wake(task, CONSOLE_PERIOD);
+	while((c = hal_console_read()) >= 0)
+	{
+		if(c == '\n' || c == '\r' || c == ' ')
+		{
+			continue;
+		}
+		if(c >= '0' && c <= '9')				//Argument for the next command
+		{
+			arg = arg * 10 + (c - '0');
+			arg_digits++;
+			continue;
+		}
+		if(c == '-' && arg_digits == 0)
+		{
+			arg_negative = 1;
+			continue;
+		}
+		for(i = 0; i < command_count && commands[i].key != c; i++)
+		{
+			;
+		}
+		if(i < command_count)
+		{
+			commands[i].fn();
+		}
+		else
+		{
+			console_put("? for commands\n");
+		}
+		arg = 0;
+		arg_digits = 0;
+		arg_negative = 0;
+	}
+}
+
+#endif /* HAL_CONSOLE */
+
+//Adds the console task to the scheduler
+void console_init(void)
+{
+	console_add('?', console_help, "list commands");
+#ifdef HAL_CONSOLE
+	task = sched_add(console_task);
+	sched_wake(task, 0);
+#endif
+}
+
+//Adds a command, replacing any command already on the same letter
+void console_add(char key, console_fn fn, const char *help)
+{
+	int i;
+
+	for(i = 0; i < command_count && commands[i].key != key; i++)
+	{
+		;
+	}
+	if(i >= CONSOLE_COMMANDS)
+	{
+		return;
+	}
+	commands[i].key = key;
+	commands[i].fn = fn;
+	commands[i].help = help;
+	if(i == command_count)
+	{
+		command_count++;
+	}
+}
@@ -0,0 +1,29 @@
+/*
+ * 	Single letter commands on the JTAG UART console.
+ *
+ * 	A scheduler task checks the console every CONSOLE_PERIOD and runs the command added for each letter
+ * 	typed, so nothing waits for input. A number typed before a letter is passed to its command through
+ * 	console_arg(), e.g. "500c" runs 'c' with 500. '?' lists the commands. Output is written with hal_putstr(), the
+ * 	console_put_ calls format numbers without needing printf. The JTAG UART also carries the telemetry frames,
+ * 	so output first waits for the end of any frame part way out(telemetry_finish()) and never lands inside one.
+ */
+
+#ifndef CONSOLE_H_
+#define CONSOLE_H_
+
+#include "timebase.h"
+
+#define CONSOLE_PERIOD		TIMEBASE_MS(10)		//Console is checked every 10ms
+#define CONSOLE_COMMANDS	32					//Maximum number of commands
+
+typedef void (*console_fn)(void);
+
+void console_init(void);								//Adds the console task to the scheduler
+void console_add(char key, console_fn fn, const char *help);	//Adds a command
+void console_put(const char *str);						//Writes a string
+void console_put_u32(alt_u32 value);					//Writes a number in decimal
+void console_put_i32(alt_32 value);						//Writes a signed number in decimal
+void console_put_line(const char *label, alt_u32 value);	//Writes "label value" on its own line
+int console_arg(alt_32 *value);							//Copies the number typed before the command, returns 0 if there was none
+
+#endif /* CONSOLE_H_ */
@@ -0,0 +1,48 @@
+/*
+ * 	Fixed point conversion from SRF05 echo length to display units, see convert.h.
+ *
+ * 	Over every echo length the SRF05 can produce(0 to 30ms) the result is within one count of the old
+ * 	float calculation, and closer to the exact decimal result than the float was.
+ */
+
+#include "convert.h"
+
+TIMING_CHECK(scale_fits, (alt_u64)SOUND_SPEED_MM_S * 50 * ((alt_u64)1 << CONVERT_Q) / TIMING_HZ <= 0xFFFFFFFFu);	//Finest scale fits 32 bits, timer of 17MHz or more
+TIMING_CHECK(scale_precise, CONVERT_SCALE(1000) >= 10000);	//Coarsest scale keeps the rounding under half a count at 9999
+
+static const alt_u32 convert_scale[4] =
+{
+	CONVERT_SCALE(1),			//CM_M = 0, DP = 0
+	CONVERT_SCALE(10),			//CM_M = 0, DP = 1
+	CONVERT_SCALE(100),			//CM_M = 1, DP = 0
+	CONVERT_SCALE(1000)			//CM_M = 1, DP = 1
+};
+
+//Converts an echo length in ticks to display units for the supplied CM_M and DP settings
+int convert_ticks(int ticks, int CM_M, int DP)
+{
+	alt_u32 scale = convert_scale[((CM_M & 1) << 1) | (DP & 1)];	//Scale factor for this setting
+
+	if(ticks <= 0)
+	{
+		return 0;
+	}
+	return (int)(((alt_u64)(alt_u32)ticks * scale) >> CONVERT_Q);	//Distance = Timer x Scale / 2^32
+}
+
+//Returns the shortest echo length in ticks that converts to value or more, used to set thresholds at start up
+int convert_limit(int value, int CM_M, int DP)
+{
+	alt_u32 scale = convert_scale[((CM_M & 1) << 1) | (DP & 1)];
+	alt_u64 ticks = (((alt_u64)value << CONVERT_Q) + scale - 1) / scale;	//Inverse of convert_ticks, rounded up
+
+	while(ticks > 0 && convert_ticks((int)(ticks - 1), CM_M, DP) >= value)
+	{
+		ticks--;
+	}
+	while(convert_ticks((int)ticks, CM_M, DP) < value)
+	{
+		ticks++;
+	}
+	return ticks > 0x7FFFFFFF ? 0x7FFFFFFF : (int)ticks;
+}
@@ -0,0 +1,32 @@
+/*
+ * 	Fixed point conversion from SRF05 echo length(timestamp ticks) to display units.
+ *
+ * 	The NIOS II core has no FPU, so instead of multiplying by the float constant 0.34029 each reading is
+ * 	multiplied by a Q32 scale factor and shifted down 32 bits. The four scale factors, one for each
+ * 	CM_M x DP setting, are worked out by the compiler from the timing profile(timing.h).
+ *
+ *	<Display Units>
+ *	CM_M = 0, DP = 0	//0.01mm per count, shown as C.CCC cm
+ *	CM_M = 0, DP = 1	//0.1mm per count, shown as CC.CC cm
+ *	CM_M = 1, DP = 0	//1mm per count, shown as M.MMM m
+ *	CM_M = 1, DP = 1	//10mm per count, shown as MM.MM m
+ *	<END>>>
+ */
+
+#ifndef CONVERT_H_
+#define CONVERT_H_
+
+#include "hal.h"
+#include "timing.h"
+
+#define SOUND_SPEED_MM_S	340290		//Speed of sound in mm per second(0.34029 x 1000000)
+#define CONVERT_Q			32			//Number of fraction bits in the scale factors
+
+//Q32 scale factor for counts of 0.01mm/div: speed x 100 counts per mm / 2 for the round trip / ticks per second
+#define CONVERT_SCALE(div)	((alt_u32)(((alt_u64)SOUND_SPEED_MM_S * 50 * ((alt_u64)1 << CONVERT_Q) \
+								+ TIMING_HZ * (div) / 2) / (TIMING_HZ * (div))))
+
+int convert_ticks(int ticks, int CM_M, int DP);		//Converts an echo length in ticks to display units
+int convert_limit(int value, int CM_M, int DP);		//Shortest echo length in ticks that converts to value or more
+
+#endif /* CONVERT_H_ */
@@ -0,0 +1,131 @@
+/*
+ * 	Timestamped echo and button edges, see edges.h.
+ *
+ * 	The interrupt only has the 32-bit timestamp counter, timebase_now() is not called from it as it
+ * 	updates the wrap count. The task extends each stamp to 64 bits against its own time, which is correct
+ * 	as long as an edge is taken from the queue within one counter wrap(85 seconds at 50MHz).
+ */
+
+#include "hal.h"
+#include "edges.h"
+#include "sched.h"
+
+#ifdef HAL_IRQ
+
+typedef struct
+{
+	volatile alt_u32 head;						//Edges pushed, written only by the interrupt
+	volatile alt_u32 tail;						//Edges taken, written only by the task
+	volatile alt_u32 stamp[EDGES_QUEUE];		//Timestamp counter of each edge
+	volatile alt_u32 level[EDGES_QUEUE];		//Pin levels of each edge
+	volatile int task;							//Task to signal, -1 if none
+} edges_queue;
+
+static edges_queue queues[EDGES_SOURCES];
+static volatile alt_u32 dropped = 0;			//Edges lost to a full queue
+
+//Pushes an edge from the interrupt
+static void edges_isr(int source, alt_u32 level, alt_u32 stamp)
+{
+	edges_queue *queue = &queues[source];
+	alt_u32 head = queue->head;
+
+	if(head - queue->tail >= EDGES_QUEUE)
+	{
+		dropped++;
+	}
+	else
+	{
+		queue->stamp[head & (EDGES_QUEUE - 1)] = stamp;
+		queue->level[head & (EDGES_QUEUE - 1)] = level;
+		queue->head = head + 1;					//Published after the slot is written
+	}
+	if(queue->task >= 0)
+	{
+		sched_signal(queue->task);
+	}
+}
+
+//Enables the interrupts, echo_mask selects the echo pins
+void edges_init(alt_u32 echo_mask)
+{
+	int source;
+
+	for(source = 0; source < EDGES_SOURCES; source++)
+	{
+		queues[source].head = 0;
+		queues[source].tail = 0;
+		queues[source].task = -1;
+	}
+	hal_irq_enable(HAL_IRQ_ECHO, echo_mask, edges_isr);
+	hal_irq_enable(HAL_IRQ_BUTTONS, 0x3, edges_isr);
+}
+
+//Signals task for every edge of source
+void edges_wake(int source, int task)
+{
+	queues[source].task = task;
+}
+
+//Takes the oldest edge, 0 if there is none
+int edges_pop(int source, edges_event *event)
+{
+	edges_queue *queue = &queues[source];
+	alt_u32 tail = queue->tail;
+	alt_u64 now;
+
+	if(tail == queue->head)
+	{
+		return 0;
+	}
+	now = timebase_now();
+	event->time = now - (alt_u32)((alt_u32)now - queue->stamp[tail & (EDGES_QUEUE - 1)]);	//Extends the stamp to 64 bits
+	event->level = queue->level[tail & (EDGES_QUEUE - 1)];
+	queue->tail = tail + 1;						//Frees the slot after it is read
+	return 1;
+}
+
+//Discards every queued edge
+void edges_flush(int source)
+{
+	queues[source].tail = queues[source].head;
+}
+
+#else
+
+static const alt_u32 dropped = 0;
+
+//No interrupts, the pins are polled
+void edges_init(alt_u32 echo_mask)
+{
+	(void)echo_mask;
+}
+
+//No interrupts to signal from
+void edges_wake(int source, int task)
+{
+	(void)source;
+	(void)task;
+}
+
+//The queues are always empty
+int edges_pop(int source, edges_event *event)
+{
+	(void)source;
+	(void)event;
+	return 0;
+}
+
+//The queues are always empty
+void edges_flush(int source)
+{
+	(void)source;
+}
+
+#endif /* HAL_IRQ */
+
+//Returns the number of edges lost to a full queue
+alt_u32 edges_dropped(void)
+{
+	return dropped;
+}
@@ -0,0 +1,36 @@
+/*
+ * 	Timestamped echo and button edges from the PIO interrupts.
+ *
+ * 	When the board has edge interrupts(HAL_IRQ) each interrupt pushes the pin levels and the time it was
+ * 	taken into a queue for its source. Each queue has one producer(the interrupt) and one consumer(a task),
+ * 	so it needs no locks: the interrupt only writes the head and the task only writes the tail.
+ * 	The interrupt also signals the task set by edges_wake(), so the task can sleep until its next timeout
+ * 	and still see an edge on the next scheduler pass. Edge times no longer depend on how often the task runs.
+ *
+ * 	Without HAL_IRQ the queues are always empty and the pins are polled instead.
+ */
+
+#ifndef EDGES_H_
+#define EDGES_H_
+
+#include "timebase.h"
+
+#define EDGES_QUEUE		32							//Edges held per source, a power of 2
+
+#define EDGES_ECHO		0							//Header input(echo) edges, as HAL_IRQ_ECHO
+#define EDGES_BUTTONS	1							//Button edges, as HAL_IRQ_BUTTONS
+#define EDGES_SOURCES	2
+
+typedef struct
+{
+	alt_u64 time;									//Time the interrupt was taken
+	alt_u32 level;									//Pin levels read by the interrupt
+} edges_event;
+
+void edges_init(alt_u32 echo_mask);					//Enables the interrupts, echo_mask selects the echo pins
+void edges_wake(int source, int task);				//Signals task for every edge of source
+int edges_pop(int source, edges_event *event);		//Takes the oldest edge, 0 if there is none
+void edges_flush(int source);						//Discards every queued edge
+alt_u32 edges_dropped(void);						//Edges lost to a full queue
+
+#endif /* EDGES_H_ */
@@ -0,0 +1,160 @@
+/*
+ * 	Noise filter for constant read mode, see filter.h.
+ *
+ * 	The median filter keeps the window twice: in the order the readings arrived, so the oldest can be
+ * 	found, and in sorted order, so the median is always the middle entry. A new reading only removes the
+ * 	oldest value and inserts itself, the window is never re-sorted. Each sorted value keeps the position of
+ * 	its reading in fifo, which no other reading in the window shares even when the values or times are
+ * 	equal, so the oldest is removed exactly and the median can be given the time of the reading it is.
+ */
+
+#include "filter.h"
+#include "ranger.h"
+
+#define FILTER_SPEED_TICKS	((alt_64)TIMEBASE_MS(1))			//Speed is per millisecond, so speed x time stays small at any clock
+
+TIMING_CHECK(tracker_fits, ((alt_u64)RANGER_ECHO_TIMEOUT << 8) <= 0x7FFFFFFFFFFFFFFFull / FILTER_SPEED_TICKS);	//Q8 echo x ticks per ms fits 63 bits
+
+static filter_mode mode = FILTER_NONE;				//Selected filter
+static int window = 1;								//Median window size
+
+static int fifo[FILTER_MAX_WINDOW];					//Median window in arrival order
+static alt_u64 fifo_times[FILTER_MAX_WINDOW];		//Time of each reading in fifo
+static int sorted[FILTER_MAX_WINDOW];				//Median window in increasing order
+static int sorted_slots[FILTER_MAX_WINDOW];			//Position in fifo of each reading in sorted
+static int count = 0;								//Readings in the median window
+static int oldest = 0;								//Position of the oldest reading in fifo
+
+static alt_64 position = 0;							//Alpha-beta echo length, Q8
+static alt_64 speed = 0;							//Alpha-beta change in echo length per millisecond, Q8
+static alt_u64 last = 0;							//Time of the last alpha-beta reading
+static alt_u64 output = 0;							//Time of the reading the last output stands for
+
+//Selects the filter and clears it
+void filter_init(filter_mode new_mode, int new_window)
+{
+	mode = new_mode;
+	window = new_window < 1 ? 1 : (new_window > FILTER_MAX_WINDOW ? FILTER_MAX_WINDOW : new_window);
+	filter_reset();
+}
+
+//Clears the readings held by the filter
+void filter_reset(void)
+{
+	count = 0;
+	oldest = 0;
+	position = 0;
+	speed = 0;
+	last = 0;
+	output = 0;
+}
+
+//Returns the first position in sorted holding a value not less than ticks
+static int filter_search(int ticks)
+{
+	int lo = 0;
+	int hi = count;
+
+	while(lo < hi)
+	{
+		int mid = (lo + hi) >> 1;
+		if(sorted[mid] < ticks)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+//Adds a reading taken at time to the median window and returns the median
+static int filter_median(alt_u64 time, int ticks)
+{
+	int pos;
+	int i;
+
+	if(count == window)								//Window full, remove the oldest reading
+	{
+		pos = filter_search(fifo[oldest]);
+		while(pos < count - 1 && sorted_slots[pos] != oldest)	//The oldest of any equal values
+		{
+			pos++;
+		}
+		for(i = pos; i < count - 1; i++)
+		{
+			sorted[i] = sorted[i + 1];
+			sorted_slots[i] = sorted_slots[i + 1];
+		}
+		count--;
+	}
+
+	pos = filter_search(ticks);						//Insert the new reading in order
+	for(i = count; i > pos; i--)
+	{
+		sorted[i] = sorted[i - 1];
+		sorted_slots[i] = sorted_slots[i - 1];
+	}
+	sorted[pos] = ticks;
+	sorted_slots[pos] = oldest;
+	count++;
+
+	fifo[oldest] = ticks;
+	fifo_times[oldest] = time;
+	oldest = (oldest + 1) % window;
+
+	output = fifo_times[sorted_slots[count >> 1]];
+	return sorted[count >> 1];
+}
+
+//Adds a reading to the alpha-beta tracker and returns its echo length estimate
+static int filter_alpha_beta(alt_u64 time, int ticks)
+{
+	alt_64 measured = (alt_64)ticks << 8;
+	alt_64 dt;
+	alt_64 error;
+
+	if(last == 0 || time <= last)					//First reading starts the tracker
+	{
+		position = measured;
+		speed = 0;
+		last = time;
+		return ticks;
+	}
+
+	dt = (alt_64)(time - last);
+	last = time;
+
+	position += speed * dt / FILTER_SPEED_TICKS;	//Predict where the echo should be now
+	error = measured - position;
+	position += (error * FILTER_ALPHA) >> 8;		//Correct the distance and speed by the error
+	speed += ((error * FILTER_BETA) >> 8) * FILTER_SPEED_TICKS / dt;
+
+	return position > 0 ? (int)(position >> 8) : 0;
+}
+
+//Adds a reading taken at time and returns the filtered echo length
+int filter_add(alt_u64 time, int ticks)
+{
+	switch(mode)
+	{
+	case FILTER_MEDIAN:
+		return filter_median(time, ticks);
+
+	case FILTER_ALPHA_BETA:
+		output = time;								//The estimate is of the newest reading
+		return filter_alpha_beta(time, ticks);
+
+	default:
+		output = time;
+		return ticks;
+	}
+}
+
+//Returns the time of the reading the last filtered echo length stands for, older than the newest with a median
+alt_u64 filter_time(void)
+{
+	return output;
+}
@@ -0,0 +1,43 @@
+/*
+ * 	Noise filter between the ranging engine and the display for constant read mode.
+ *
+ * 	Works on echo lengths in ticks so it does not depend on the CM_M or DP settings.
+ *
+ *	<Modes>
+ *	FILTER_NONE			//Readings are passed straight through
+ *	FILTER_MEDIAN		//Median of the last window readings. Removes single spikes, delays the output by
+ *						//(window - 1) / 2 readings and costs one binary search and one shift of up to window values
+ *	FILTER_ALPHA_BETA	//Alpha-beta tracker, a fixed gain Kalman filter following distance and speed.
+ *						//Smooths jitter with no lag on steady movement, a few integer multiplies per reading
+ *	<END>>>
+ */
+
+#ifndef FILTER_H_
+#define FILTER_H_
+
+#include "hal.h"
+
+#define FILTER_MAX_WINDOW		15					//Largest median window
+#define FILTER_ALPHA			128					//Alpha-beta distance gain, 0.5 in Q8
+#define FILTER_BETA				26					//Alpha-beta speed gain, 0.1 in Q8
+
+#ifndef FILTER_DEFAULT_MODE
+#define FILTER_DEFAULT_MODE		FILTER_MEDIAN		//Filter used in constant read mode
+#endif
+#ifndef FILTER_DEFAULT_WINDOW
+#define FILTER_DEFAULT_WINDOW	3					//Median window used in constant read mode
+#endif
+
+typedef enum
+{
+	FILTER_NONE,
+	FILTER_MEDIAN,
+	FILTER_ALPHA_BETA
+} filter_mode;
+
+void filter_init(filter_mode mode, int window);		//Selects the filter and clears it
+void filter_reset(void);							//Clears the readings held by the filter
+int filter_add(alt_u64 time, int ticks);			//Adds a reading taken at time and returns the filtered echo length
+alt_u64 filter_time(void);							//Time of the reading the last filtered echo length stands for
+
+#endif /* FILTER_H_ */
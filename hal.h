@@ -0,0 +1,150 @@
+/*
+ * 	Hardware Abstraction Layer(HAL) for the DE0 PIOs and the timestamp driver.
+ *
+ * 	Every access Program.c makes to the board goes through one of the hal_ calls below.
+ * 	On the NIOS II processor each call is a macro that expands to the same IORD/IOWR or alt_timestamp
+ * 	call that was used before, so the HAL adds no cost on the board.
+ *
+ * 	When compiled with HOST_SIM defined the calls are instead implemented by hal_host.c, which models
+ * 	the PIOs and a SRF05 Ultrasonic Range Finder on a virtual clock so the program can run on Linux.
+ *
+ *	<PIO Map>
+ *	PUSHBUTTONS1_2_BASE		= Buttons 1 and 2, active low (bit 0 = button 1, bit 1 = button 2)
+ *	DE0SWITCHES_BASE		= Switches 0 to 9
+ *	SSEG_BASE				= Four 7-segment displays, one byte per display, active low
+ *	DE0_LEDS_BASE			= LEDs 0 to 9
+ *	HEADERINPUTS_BASE		= Header input pins (bit 0 = SRF05 echo)
+ *	HEADEROUTPUTS_BASE		= Header output pins (bit 0 = SRF05 trigger), written through outset/outclear
+ *	CFI_FLASH_NAME			= On board flash, used for saved settings when the design includes it
+ *	JTAG_UART_BASE			= JTAG UART, read without waiting for console commands
+ *	HEADERINPUTS_IRQ		= Edge capture interrupt of the header inputs, when the PIO is built with one
+ *	PUSHBUTTONS1_2_IRQ		= Edge capture interrupt of the buttons, when the PIO is built with one
+ *	<END>>>
+ *
+ * 	HAL_FLASH is defined when a flash device is available. The hal_flash_ calls are not macros as the
+ * 	flash device has to be opened once, they are implemented by hal_flash.c on the board.
+ * 	HAL_CONSOLE is defined when the JTAG UART can be used directly, hal_console_read() is in hal_console.c
+ * 	as it must only read the data register once per character.
+ * 	HAL_IRQ is defined when both the header input and button PIOs capture any edge as an interrupt.
+ * 	hal_irq_enable() is in hal_irq.c, its handler is called from the interrupt with the pin levels and the
+ * 	timestamp counter read as the interrupt was taken. Without HAL_IRQ the echo and button pins are polled.
+ * 	hal_idle() is called by the scheduler when no task can run for a while. The NIOS II has no instruction that
+ * 	waits for an interrupt, so on the board it returns at once and the loop polls, the host jumps its clock.
+ */
+
+#ifndef HAL_H_
+#define HAL_H_
+
+#ifndef HOST_SIM
+
+#include "alt_types.h"					//for the alt_u32 and alt_u64 types
+#include "sys/alt_stdio.h"   			//for the alt_putstr function.  Outputs to Eclipse console
+#include "altera_avalon_pio_regs.h"  	//for the PIO I/O functions
+#include "sys/alt_timestamp.h"  		//Timestamp Driver
+#include "system.h"
+
+#define setHeaderOuts HEADEROUTPUTS_BASE+0x10  	//HEADEROUTPUTS_BASE is defined in system.h of the _bsp file.  It refers to the base address in the Qsys design
+												//the hex offset (in this case 0x10, which is 16 in decimal) gives the number of bytes of offset
+												//each register is 32 bits, or 4 bytes
+												//so to shift to register 4, which is the outset register, we need 4 * (4 bytes) = 16 bytes
+#define clearHeaderOuts HEADEROUTPUTS_BASE+0x14 //to shift to register 5 (the 'outclear' register) we need to shift by 5 * (4 bytes) = 20 bytes, (=0x14 bytes)
+												// offset of 5 corresponds to the 'outclear' register of the PIO.
+
+#define hal_buttons_read()			IORD_ALTERA_AVALON_PIO_DATA(PUSHBUTTONS1_2_BASE)	//Read button states
+#define hal_switches_read()			IORD_ALTERA_AVALON_PIO_DATA(DE0SWITCHES_BASE)		//Read switch states
+#define hal_header_read()			IORD_ALTERA_AVALON_PIO_DATA(HEADERINPUTS_BASE)		//Read header input pins
+#define hal_sseg_write(value)		IOWR_ALTERA_AVALON_PIO_DATA(SSEG_BASE,(value))		//Write the SSEG display
+#define hal_leds_write(value)		IOWR_ALTERA_AVALON_PIO_DATA(DE0_LEDS_BASE,(value))	//Write the LEDs
+#define hal_header_set(mask)		IOWR_ALTERA_AVALON_PIO_DATA(setHeaderOuts,(mask))	//Turn on header output pins in mask
+#define hal_header_clear(mask)		IOWR_ALTERA_AVALON_PIO_DATA(clearHeaderOuts,(mask))	//Turn off header output pins in mask
+
+#define hal_timestamp_start()		alt_timestamp_start()								//Restart the timestamp counter at 0
+#define hal_timestamp()				alt_timestamp()										//Read the timestamp counter
+#define hal_timestamp_freq()		alt_timestamp_freq()								//Timestamp ticks per second
+
+#define hal_putstr(str)				alt_putstr(str)										//Print a string to the JTAG UART
+#define hal_idle(ticks)				((void)(ticks))										//Nothing to wait with, the scheduler loop polls
+
+#ifdef CFI_FLASH_NAME
+#define HAL_FLASH					CFI_FLASH_NAME										//Flash device used for saved settings
+#endif
+
+#ifdef JTAG_UART_BASE
+#include "altera_avalon_jtag_uart_regs.h"	//for the JTAG UART registers
+
+#define HAL_CONSOLE					JTAG_UART_BASE										//JTAG UART used for console commands
+
+#define hal_console_space()			((IORD_ALTERA_AVALON_JTAG_UART_CONTROL(HAL_CONSOLE) & ALTERA_AVALON_JTAG_UART_CONTROL_WSPACE_MSK) >> ALTERA_AVALON_JTAG_UART_CONTROL_WSPACE_OFST)	//Free space in the transmit FIFO
+#define hal_console_write(c)		IOWR_ALTERA_AVALON_JTAG_UART_DATA(HAL_CONSOLE,(c))	//Write a byte to the transmit FIFO
+#endif
+
+#if defined(HEADERINPUTS_IRQ) && defined(PUSHBUTTONS1_2_IRQ)
+#define HAL_IRQ																			//Echo and button edges interrupt
+#endif
+
+
+#else
+
+typedef unsigned char		alt_u8;		//Host versions of the alt_types.h types
+typedef signed char			alt_8;
+typedef unsigned short		alt_u16;
+typedef short				alt_16;
+typedef unsigned int		alt_u32;
+typedef int					alt_32;
+typedef unsigned long long	alt_u64;
+typedef long long			alt_64;
+
+#ifndef TIMESTAMP_TIMER_FREQ
+#define TIMESTAMP_TIMER_FREQ 50000000	//Simulated timestamp frequency, same as the DE0 design
+#endif
+
+int hal_buttons_read(void);
+int hal_switches_read(void);
+int hal_header_read(void);
+void hal_sseg_write(int value);
+void hal_leds_write(int value);
+void hal_header_set(int mask);
+void hal_header_clear(int mask);
+
+int hal_timestamp_start(void);
+alt_u32 hal_timestamp(void);
+alt_u32 hal_timestamp_freq(void);
+
+int hal_putstr(const char *str);
+void hal_idle(alt_u64 ticks);
+
+#define HAL_FLASH					"/dev/sim_flash"	//File backed flash model in hal_host.c
+#define HAL_CONSOLE					0					//Scripted console input in hal_host.c
+
+int hal_console_space(void);
+void hal_console_write(int c);
+
+#ifndef HOST_NO_IRQ
+#define HAL_IRQ									//Simulated edge interrupts in hal_host.c, build with HOST_NO_IRQ to poll
+#endif
+
+#endif
+
+#ifdef HAL_FLASH
+#define HAL_FLASH_SECTOR			0x10000				//Erase sector size of the DE0's S29AL032D flash
+
+int hal_flash_read(alt_u32 offset, void *dest, int length);			//Reads from the flash
+int hal_flash_write(alt_u32 offset, const void *src, int length);	//Programs erased flash without erasing it first
+int hal_flash_erase(alt_u32 offset);								//Erases the sector that holds offset
+#endif
+
+#ifdef HAL_CONSOLE
+int hal_console_read(void);											//Next character typed on the console, -1 if none
+#endif
+
+#ifdef HAL_IRQ
+#define HAL_IRQ_ECHO				0					//Header input PIO
+#define HAL_IRQ_BUTTONS				1					//Button PIO
+#define HAL_IRQ_SOURCES				2
+
+typedef void (*hal_irq_fn)(int source, alt_u32 level, alt_u32 stamp);
+
+void hal_irq_enable(int source, alt_u32 mask, hal_irq_fn fn);		//Calls fn from the interrupt on any edge of the pins in mask
+#endif
+
+#endif /* HAL_H_ */
@@ -0,0 +1,28 @@
+/*
+ * 	Console input for the Hardware Abstraction Layer(hal.h) on the board.
+ *
+ * 	alt_getchar() waits for a character, so the JTAG UART data register is read directly instead.
+ * 	Reading the register takes the character out of the receive FIFO, so it is only read once.
+ */
+
+#ifndef HOST_SIM
+
+#include "hal.h"
+
+#ifdef HAL_CONSOLE
+
+//Returns the next character typed on the console, -1 if none
+int hal_console_read(void)
+{
+	int data = IORD_ALTERA_AVALON_JTAG_UART_DATA(HAL_CONSOLE);
+
+	if(!(data & ALTERA_AVALON_JTAG_UART_DATA_RVALID_MSK))
+	{
+		return -1;
+	}
+	return data & ALTERA_AVALON_JTAG_UART_DATA_DATA_MSK;
+}
+
+#endif /* HAL_CONSOLE */
+
+#endif /* HOST_SIM */
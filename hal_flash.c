@@ -0,0 +1,60 @@
+/*
+ * 	Flash access for the Hardware Abstraction Layer(hal.h) on the board.
+ *
+ * 	Uses the HAL flash driver of the CFI flash controller, opened on first use. Nothing is built when the
+ * 	design has no flash, or for the host simulation which models the flash in hal_host.c.
+ */
+
+#ifndef HOST_SIM
+
+#include "hal.h"
+
+#ifdef HAL_FLASH
+
+#include "sys/alt_flash.h"					//for the flash driver
+
+static alt_flash_fd *flash = 0;				//Flash device, 0 until opened
+
+//Opens the flash device on first use, returns 0 if it can not be opened
+static int hal_flash_open(void)
+{
+	if(!flash)
+	{
+		flash = alt_flash_open_dev(HAL_FLASH);
+	}
+	return flash != 0;
+}
+
+//Reads from the flash
+int hal_flash_read(alt_u32 offset, void *dest, int length)
+{
+	if(!hal_flash_open())
+	{
+		return -1;
+	}
+	return alt_read_flash(flash, (int)offset, dest, length);
+}
+
+//Programs erased flash without erasing it first
+int hal_flash_write(alt_u32 offset, const void *src, int length)
+{
+	if(!hal_flash_open())
+	{
+		return -1;
+	}
+	return alt_write_flash_block(flash, (int)(offset & ~(HAL_FLASH_SECTOR - 1)), (int)offset, src, length);
+}
+
+//Erases the sector that holds offset
+int hal_flash_erase(alt_u32 offset)
+{
+	if(!hal_flash_open())
+	{
+		return -1;
+	}
+	return alt_erase_flash_block(flash, (int)(offset & ~(HAL_FLASH_SECTOR - 1)), HAL_FLASH_SECTOR);
+}
+
+#endif /* HAL_FLASH */
+
+#endif /* HOST_SIM */
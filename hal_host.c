@@ -0,0 +1,934 @@
+/*
+ * 	Linux backend for the Hardware Abstraction Layer(hal.h).
+ *
+ * 	Models the DE0 PIOs, the timestamp timer and up to 8 SRF05 Ultrasonic Range Finders on a virtual clock
+ * 	so that Program.c can run, be profiled and be regression tested on a workstation.
+ * 	Every HAL call advances the virtual clock by the cost of one bus access, so a busy-wait loop
+ * 	takes the same number of virtual ticks it would on the board but runs many times faster than real time.
+ *
+ * 	Build:	gcc -DHOST_SIM -O2 -o srf05_sim *.c -lm
+ * 	Add -DHOST_NO_IRQ to build the polled version, otherwise the echo and button edge interrupts are modelled:
+ * 	after each bus access the pins are compared with their last levels and a changed pin in an enabled mask
+ * 	calls the handler, as the PIO's edge capture would.
+ *
+ *	<Environment Settings>
+ *	SIM_SECONDS			= Virtual seconds to run before printing the report and exiting (default 5)
+ *	SIM_SWITCHES		= Switch states as hex values, with later changes as value@ms, e.g. "0x001,0x011@2000" (default 0x001)
+ *	SIM_PRESS			= Button presses as button@ms pairs, e.g. "1@10,2@3000" (default "1@10")
+ *	SIM_HOLD_MS			= How long each button press is held (default 50)
+ *	SIM_TARGET_MM		= Distance to the target in mm, with later moves as mm@ms, e.g. "300,1500@4000" (default 500)
+ *	SIM_SPREAD_MM		= Extra distance for each further sensor, sensor n sees SIM_TARGET_MM + n x SIM_SPREAD_MM (default 100)
+ *	SIM_SWING_MM		= Amplitude of a sinusoidal target movement in mm (default 0)
+ *	SIM_PERIOD_MS		= Period of the target movement (default 2000)
+ *	SIM_NOISE_TICKS		= Maximum random echo jitter in ticks (default 0)
+ *	SIM_SPIKE_PCT		= Percentage of echoes replaced by a spurious reflection at a random distance (default 0)
+ *	SIM_FAULT			= Sensor fault from ms onwards as fault@ms, fault 1 = unplugged, 2 = echo stuck high (default none)
+ *	SIM_ECHO_DELAY_US	= Delay from the end of the trigger to the start of the echo (default 700)
+ *	SIM_GAIN_PPM		= Sensor gain error, echo lengths are scaled by this over 1000000 (default 1000000)
+ *	SIM_OFFSET_US		= Sensor offset added to every echo length (default 0)
+ *	SIM_TEMP			= Air temperature in tenths of a degree C, sets the speed of sound (default none, 340.29m/s)
+ *	SIM_BUS_TICKS		= Virtual ticks used by each HAL call (default 8)
+ *	SIM_VERBOSE			= When set, print every SSEG and LED write with its virtual time
+ *	SIM_FLASH			= File that holds the flash contents between runs (default none, flash starts erased)
+ *	SIM_CONSOLE			= Console input as text@ms, e.g. "p@4900" (default none)
+ *	SIM_TELEMETRY		= File that receives every byte written to the JTAG UART, binary and text (default none, discarded)
+ *	SIM_UART_SPACE		= Free space the JTAG UART's transmit FIFO gives on each check (default 64)
+ *	SIM_TRACE			= Trace to replay, the CSV written by tools/telemetry_decode (default none)
+ *	SIM_SKIP			= When set, a header read jumps the clock to the next echo edge instead of polling up to it
+ *	<END>>>
+ *
+ * 	A replayed trace replaces the SRF05 model and the scripted switches and buttons: the inputs follow
+ * 	the trace's input records at their recorded times, and each trigger of a sensor is answered with that
+ * 	sensor's next recorded echo(or fault). The run ends when a sensor has no recorded echoes left, one second
+ * 	after the last record, or after SIM_SECONDS if it is set. SIM_SKIP with a large SIM_BUS_TICKS runs a long trace as fast as possible while
+ * 	still timing every echo to the tick, and SIM_VERBOSE gives the output to compare between versions.
+ *
+ * 	Header output pins above the sensor triggers are alarm outputs: each time one turns on, the time since the
+ * 	latest echo ended is its reaction latency, reported as a mean and maximum.
+ */
+
+#ifdef HOST_SIM
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hal.h"
+#include "timing.h"
+#include "ranger.h"
+
+#define SIM_SOUND_MM_S		340290		//Speed of sound used by the SRF05 model (mm/s), matches SOUND_SPEED_MM_S in convert.h
+#define SIM_MAX_PRESSES		32			//Maximum number of scripted button presses
+#define SIM_MAX_SWITCHES	32			//Maximum number of scripted switch changes
+#define SIM_SENSORS			8			//Number of modelled SRF05s, sensor n on header bit n
+#define SIM_FLASH_SIZE		0x400000	//Size of the DE0's 4MB flash
+#define SIM_MAX_CONSOLE		32			//Maximum number of scripted console inputs
+#define SIM_NO_ECHO_US		30000		//Echo length of the SRF05 when no object is detected
+#define SIM_MAX_RANGE_MM	4000		//Maximum range of the SRF05
+#define SIM_TRIGGER_US		10			//Minimum trigger pulse length of the SRF05
+#define SIM_TRACE_INPUT		15			//Channel of trace input records, as TELEMETRY_INPUT
+#define SIM_STUCK_US		1000000		//Echo length given for a recorded stuck echo
+
+typedef struct
+{
+	int button;							//Button number 1 or 2
+	alt_u64 at;							//Virtual tick the button is pressed
+} sim_press;
+
+typedef struct
+{
+	int value;							//Switch states
+	alt_u64 at;							//Virtual tick the switches change
+} sim_switch;
+
+typedef struct
+{
+	char text[32];						//Characters typed
+	alt_u64 at;							//Virtual tick they are typed at
+} sim_input;
+
+typedef struct
+{
+	alt_u64 at;							//Virtual tick, recorded time less the first record's time
+	int channel;						//Sensor, or SIM_TRACE_INPUT
+	int error;							//ranger_err of the recorded echo
+	alt_u32 ticks;						//Echo length, or input word for input records
+} sim_trace_row;
+
+static int sim_ready = 0;				//Set once the settings have been read
+
+static alt_u64 sim_now = 0;				//Virtual clock, ticks since power on
+static alt_u64 sim_ts_base = 0;			//Virtual clock value when the timestamp was last restarted
+static alt_u64 sim_end = 0;				//Virtual clock value to stop the simulation at
+static alt_u32 sim_bus_ticks = 8;		//Ticks per HAL call
+
+static sim_switch sim_switches[SIM_MAX_SWITCHES];
+static sim_switch sim_moves[SIM_MAX_SWITCHES];	//Target distance changes, in mm
+static int sim_move_count = 0;
+static int sim_switch_count = 0;
+static sim_press sim_presses[SIM_MAX_PRESSES];
+static int sim_press_count = 0;
+static sim_input sim_console[SIM_MAX_CONSOLE];
+static int sim_console_count = 0;
+static int sim_console_next = 0;		//Next input to be typed
+static int sim_console_pos = 0;			//Next character of that input
+static alt_u64 sim_hold = 0;			//Button hold time in ticks
+
+static double sim_target_mm = 500;		//Target model
+static double sim_spread_mm = 100;
+static double sim_swing_mm = 0;
+static double sim_period_ms = 2000;
+static int sim_noise = 0;				//Echo jitter in ticks
+static int sim_spike = 0;				//Percentage of spurious echoes
+static int sim_fault = 0;				//Sensor fault, 1 = unplugged, 2 = echo stuck high
+static alt_u64 sim_fault_at = 0;		//Virtual tick the fault starts
+static alt_u64 sim_echo_delay = 0;		//Trigger to echo delay in ticks
+static double sim_gain = 1;				//Sensor gain error
+static double sim_offset_us = 0;		//Sensor offset
+static double sim_sound = SIM_SOUND_MM_S;	//Speed of sound
+static unsigned int sim_seed = 1;		//Random number generator state
+static int sim_verbose = 0;
+
+static int sim_header_outs = 0;			//Header output pin states
+static alt_u64 sim_trigger_at[SIM_SENSORS];	//Virtual tick each trigger went high
+static alt_u64 sim_echo_rise[SIM_SENSORS];		//Virtual tick each echo goes high
+static alt_u64 sim_echo_fall[SIM_SENSORS];		//Virtual tick each echo goes low
+
+static alt_u64 sim_triggers = 0;		//Number of valid trigger pulses
+static alt_u64 sim_results = 0;			//Number of SSEG writes following a trigger
+static alt_u64 sim_latency = 0;			//Sum of trigger to SSEG write times
+static alt_u64 sim_pending = 0;			//Trigger time waiting for its SSEG write, 0 if none
+static alt_u64 sim_sseg_writes = 0;
+static alt_u64 sim_led_writes = 0;
+static alt_u64 sim_alarms = 0;			//Alarm pins turned on
+static alt_u64 sim_alarm_latency = 0;	//Sum of echo end to alarm pin times
+static alt_u64 sim_alarm_worst = 0;		//Longest echo end to alarm pin time
+static struct timespec sim_wall;		//Wall clock at start
+
+static alt_u8 *sim_flash = NULL;		//Flash contents, allocated on first use
+static FILE *sim_flash_file = NULL;		//Backing file, NULL if the flash is not kept
+static alt_u64 sim_flash_writes = 0;	//Bytes programmed
+static alt_u64 sim_flash_erases = 0;	//Sectors erased
+
+static FILE *sim_telemetry = NULL;		//File that receives console bytes
+static alt_u64 sim_console_bytes = 0;	//Bytes written to the console
+static int sim_uart_space = 64;			//Free space given for the transmit FIFO
+
+static sim_trace_row *sim_trace = NULL;	//Trace being replayed, NULL if none
+static long sim_trace_count = 0;
+static long sim_trace_next[SIM_SENSORS];	//Next row to search for each sensor's echo
+static long sim_trace_input = -1;		//Latest input row that has happened
+static alt_u64 sim_trace_used = 0;		//Recorded echoes replayed
+static int sim_skip = 0;				//Jump to echo edges
+
+#ifdef HAL_IRQ
+static hal_irq_fn sim_irq_fn[HAL_IRQ_SOURCES];		//Interrupt handlers, NULL until enabled
+static alt_u32 sim_irq_mask[HAL_IRQ_SOURCES];		//Pins that interrupt
+static alt_u32 sim_irq_level[HAL_IRQ_SOURCES];		//Pin levels at the last check
+static int sim_in_irq = 0;				//Set while a handler runs
+static alt_u64 sim_irqs = 0;			//Interrupts taken
+#endif
+
+//Reads an integer setting from the environment
+static long sim_env(const char *name, long def)
+{
+	const char *value = getenv(name);
+	return value ? strtol(value, NULL, 0) : def;
+}
+
+//Converts microseconds to virtual ticks
+static alt_u64 sim_us(double us)
+{
+	return (alt_u64)(us * (TIMESTAMP_TIMER_FREQ / 1000000.0));
+}
+
+//Prints the report and ends the program
+static void sim_report(void)
+{
+	struct timespec end;
+	double wall, virt;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	wall = (end.tv_sec - sim_wall.tv_sec) + (end.tv_nsec - sim_wall.tv_nsec) / 1e9;
+	virt = (double)sim_now / TIMESTAMP_TIMER_FREQ;
+
+	printf("\n--- srf05 sim ---\n");
+	printf("virtual time      %.3f s\n", virt);
+	printf("timer             %llu Hz, trigger %llu ticks\n", (alt_u64)TIMING_HZ, (alt_u64)RANGER_TRIGGER_TICKS);
+	printf("wall time         %.3f s (%.1fx real time)\n", wall, wall > 0 ? virt / wall : 0);
+	printf("triggers          %llu (%.2f /s)\n", sim_triggers, sim_triggers / virt);
+	printf("results           %llu\n", sim_results);
+	if(sim_results)
+	{
+		printf("mean latency      %.3f ms (trigger to display)\n",
+			(double)sim_latency / sim_results * 1000.0 / TIMESTAMP_TIMER_FREQ);
+		printf("host cost         %.1f us per result\n", wall * 1e6 / sim_results);
+	}
+	printf("sseg writes       %llu\n", sim_sseg_writes);
+	printf("led writes        %llu\n", sim_led_writes);
+	if(sim_alarms)
+	{
+		printf("alarms            %llu, latency mean %.2f us, max %.2f us (echo end to pin)\n", sim_alarms,
+			(double)sim_alarm_latency / sim_alarms * 1e6 / TIMESTAMP_TIMER_FREQ,
+			(double)sim_alarm_worst * 1e6 / TIMESTAMP_TIMER_FREQ);
+	}
+#ifdef HAL_IRQ
+	printf("interrupts        %llu\n", sim_irqs);
+#endif
+	if(sim_trace)
+	{
+		printf("trace echoes      %llu replayed\n", sim_trace_used);
+	}
+	if(sim_console_bytes)
+	{
+		printf("console bytes     %llu\n", sim_console_bytes);
+	}
+	if(sim_flash)
+	{
+		printf("flash             %llu bytes written, %llu sectors erased\n", sim_flash_writes, sim_flash_erases);
+	}
+	exit(0);
+}
+
+//Loads a trace from the CSV written by tools/telemetry_decode
+static void sim_trace_load(const char *path)
+{
+	FILE *in = fopen(path, "r");
+	char line[128];
+	long size = 0;
+	alt_u64 first = 0;
+	int i;
+
+	if(!in)
+	{
+		perror(path);
+		exit(1);
+	}
+	while(fgets(line, sizeof(line), in))
+	{
+		unsigned long long time;
+		unsigned int ticks;
+		int channel, error;
+
+		if(sscanf(line, "%llu,%d,%d,%u", &time, &channel, &error, &ticks) != 4)
+		{
+			continue;						//Header line
+		}
+		if(sim_trace_count == size)
+		{
+			size = size ? size * 2 : 1024;
+			sim_trace = realloc(sim_trace, size * sizeof(sim_trace_row));
+		}
+		if(sim_trace_count == 0)
+		{
+			first = time;
+		}
+		sim_trace[sim_trace_count].at = time > first ? time - first : 0;
+		sim_trace[sim_trace_count].channel = channel;
+		sim_trace[sim_trace_count].error = error;
+		sim_trace[sim_trace_count].ticks = ticks;
+		sim_trace_count++;
+	}
+	fclose(in);
+	for(i = 0; i < SIM_SENSORS; i++)
+	{
+		sim_trace_next[i] = 0;
+	}
+}
+
+//Returns the trace's input word at the current virtual time
+static alt_u32 sim_trace_word(void)
+{
+	long i;
+
+	for(i = sim_trace_input + 1; i < sim_trace_count && sim_trace[i].at <= sim_now; i++)
+	{
+		if(sim_trace[i].channel == SIM_TRACE_INPUT)
+		{
+			sim_trace_input = i;
+		}
+	}
+	return sim_trace_input >= 0 ? sim_trace[sim_trace_input].ticks : 0;
+}
+
+//Reads the settings on the first HAL call
+static void sim_init(void)
+{
+	const char *press = getenv("SIM_PRESS");
+	const char *switches = getenv("SIM_SWITCHES");
+	const char *fault = getenv("SIM_FAULT");
+	const char *console = getenv("SIM_CONSOLE");
+	const char *telemetry = getenv("SIM_TELEMETRY");
+	const char *target = getenv("SIM_TARGET_MM");
+	char buf[256];
+	char *item;
+
+	sim_ready = 1;
+	clock_gettime(CLOCK_MONOTONIC, &sim_wall);
+
+	sim_end = (alt_u64)sim_env("SIM_SECONDS", 5) * TIMESTAMP_TIMER_FREQ;
+	sim_hold = sim_us(sim_env("SIM_HOLD_MS", 50) * 1000.0);
+	sim_spread_mm = sim_env("SIM_SPREAD_MM", 100);
+	sim_swing_mm = sim_env("SIM_SWING_MM", 0);
+	sim_period_ms = sim_env("SIM_PERIOD_MS", 2000);
+	sim_noise = (int)sim_env("SIM_NOISE_TICKS", 0);
+	sim_spike = (int)sim_env("SIM_SPIKE_PCT", 0);
+	sim_echo_delay = sim_us(sim_env("SIM_ECHO_DELAY_US", 700));
+	sim_gain = sim_env("SIM_GAIN_PPM", 1000000) / 1e6;
+	sim_offset_us = sim_env("SIM_OFFSET_US", 0);
+	if(getenv("SIM_TEMP"))
+	{
+		sim_sound = 331300 + 60.6 * sim_env("SIM_TEMP", 0);	//331.3m/s + 0.606m/s per degree
+	}
+	sim_bus_ticks = (alt_u32)sim_env("SIM_BUS_TICKS", 8);
+	sim_verbose = getenv("SIM_VERBOSE") != NULL;
+	sim_telemetry = telemetry ? fopen(telemetry, "wb") : NULL;
+	sim_uart_space = (int)sim_env("SIM_UART_SPACE", 64);
+	sim_skip = getenv("SIM_SKIP") != NULL;
+	if(getenv("SIM_TRACE"))
+	{
+		sim_trace_load(getenv("SIM_TRACE"));
+		if(!getenv("SIM_SECONDS") && sim_trace_count)
+		{
+			sim_end = sim_trace[sim_trace_count - 1].at + TIMESTAMP_TIMER_FREQ;	//One second past the last record
+		}
+	}
+
+	if(fault)
+	{
+		double ms = 0;
+		sscanf(fault, "%d@%lf", &sim_fault, &ms);
+		sim_fault_at = sim_us(ms * 1000.0);
+	}
+
+	strncpy(buf, press ? press : "1@10", sizeof(buf) - 1);
+	buf[sizeof(buf) - 1] = 0;
+	for(item = strtok(buf, ","); item && sim_press_count < SIM_MAX_PRESSES; item = strtok(NULL, ","))
+	{
+		int button;
+		double ms;
+		if(sscanf(item, "%d@%lf", &button, &ms) == 2)
+		{
+			sim_presses[sim_press_count].button = button;
+			sim_presses[sim_press_count].at = sim_us(ms * 1000.0);
+			sim_press_count++;
+		}
+	}
+
+	strncpy(buf, switches ? switches : "0x001", sizeof(buf) - 1);
+	buf[sizeof(buf) - 1] = 0;
+	for(item = strtok(buf, ","); item && sim_switch_count < SIM_MAX_SWITCHES; item = strtok(NULL, ","))
+	{
+		char *at = strchr(item, '@');
+		sim_switches[sim_switch_count].value = (int)strtol(item, NULL, 16);
+		sim_switches[sim_switch_count].at = at ? sim_us(atof(at + 1) * 1000.0) : 0;
+		sim_switch_count++;
+	}
+
+	strncpy(buf, target ? target : "500", sizeof(buf) - 1);
+	buf[sizeof(buf) - 1] = 0;
+	for(item = strtok(buf, ","); item && sim_move_count < SIM_MAX_SWITCHES; item = strtok(NULL, ","))
+	{
+		char *at = strchr(item, '@');
+		sim_moves[sim_move_count].value = (int)strtol(item, NULL, 0);
+		sim_moves[sim_move_count].at = at ? sim_us(atof(at + 1) * 1000.0) : 0;
+		sim_move_count++;
+	}
+
+	strncpy(buf, console ? console : "", sizeof(buf) - 1);
+	buf[sizeof(buf) - 1] = 0;
+	for(item = strtok(buf, ","); item && sim_console_count < SIM_MAX_CONSOLE; item = strtok(NULL, ","))
+	{
+		char *at = strrchr(item, '@');
+		if(at && at != item)
+		{
+			*at = 0;
+			strncpy(sim_console[sim_console_count].text, item, sizeof(sim_console[0].text) - 1);
+			sim_console[sim_console_count].at = sim_us(atof(at + 1) * 1000.0);
+			sim_console_count++;
+		}
+	}
+}
+
+static void sim_irq_check(void);
+
+//Advances the virtual clock by one bus access
+static void sim_step(void)
+{
+	if(!sim_ready)
+	{
+		sim_init();
+	}
+	sim_now += sim_bus_ticks;
+	if(sim_now >= sim_end)
+	{
+		sim_report();
+	}
+	sim_irq_check();
+}
+
+//Returns the target distance of a sensor at the current virtual time
+static double sim_target(int sensor)
+{
+	double t = (double)sim_now / TIMESTAMP_TIMER_FREQ;
+	int i;
+
+	for(i = 0; i < sim_move_count; i++)
+	{
+		if(sim_now >= sim_moves[i].at)
+		{
+			sim_target_mm = sim_moves[i].value;	//Latest move that has happened
+		}
+	}
+	return sim_target_mm + sensor * sim_spread_mm + sim_swing_mm * sin(2.0 * M_PI * t * 1000.0 / sim_period_ms);
+}
+
+//Models the SRF05 ranging cycle of a sensor once its trigger pulse ends
+static void sim_srf05_trigger(int sensor)
+{
+	double mm = sim_target(sensor);
+	double us;
+	long ticks;
+
+	if(sim_fault == 1 && sim_now >= sim_fault_at)
+	{
+		return;								//Unplugged sensor never answers
+	}
+	if(sim_now - sim_trigger_at[sensor] < sim_us(SIM_TRIGGER_US) || sim_now < sim_echo_fall[sensor])
+	{
+		return;								//Pulse too short or still busy with the last echo
+	}
+
+	if(sim_trace)							//Answer with the sensor's next recorded echo
+	{
+		long i = sim_trace_next[sensor];
+
+		while(i < sim_trace_count && sim_trace[i].channel != sensor)
+		{
+			i++;
+		}
+		if(i >= sim_trace_count)
+		{
+			sim_report();					//Trace finished
+		}
+		sim_trace_next[sensor] = i + 1;
+		sim_trace_used++;
+		sim_triggers++;
+		if(!sim_pending)
+		{
+			sim_pending = sim_trigger_at[sensor] ? sim_trigger_at[sensor] : 1;
+		}
+		if(sim_trace[i].error == 1)
+		{
+			return;							//Recorded no echo
+		}
+		sim_echo_rise[sensor] = sim_now + sim_echo_delay;
+		sim_echo_fall[sensor] = sim_echo_rise[sensor] + (sim_trace[i].error == 2 ? sim_us(SIM_STUCK_US) : sim_trace[i].ticks);
+		return;
+	}
+
+	if(sim_spike > 0)
+	{
+		sim_seed = sim_seed * 1103515245u + 12345u;
+		if((int)((sim_seed >> 16) % 100) < sim_spike)
+		{
+			sim_seed = sim_seed * 1103515245u + 12345u;
+			mm = (sim_seed >> 16) % SIM_MAX_RANGE_MM;	//Spurious reflection
+		}
+	}
+
+	if(mm <= 0 || mm > SIM_MAX_RANGE_MM)
+	{
+		us = SIM_NO_ECHO_US;				//No object detected
+	}
+	else
+	{
+		us = mm * 2.0 / sim_sound * 1e6 * sim_gain + sim_offset_us;	//Round trip time of the sound
+	}
+
+	ticks = (long)sim_us(us);
+	if(sim_noise > 0)
+	{
+		sim_seed = sim_seed * 1103515245u + 12345u;
+		ticks += (long)((sim_seed >> 16) % (2 * sim_noise + 1)) - sim_noise;
+	}
+	if(ticks < 1)
+	{
+		ticks = 1;
+	}
+
+	sim_echo_rise[sensor] = sim_now + sim_echo_delay;
+	sim_echo_fall[sensor] = sim_echo_rise[sensor] + (alt_u64)ticks;
+	sim_triggers++;
+	if(!sim_pending)
+	{
+		sim_pending = sim_trigger_at[sensor] ? sim_trigger_at[sensor] : 1;
+	}
+}
+
+//Returns the button pin levels at the current virtual time, active low
+static int sim_buttons(void)
+{
+	int buttons = 0x3;
+	int i;
+
+	if(sim_trace)
+	{
+		return ~(sim_trace_word() >> 10) & 0x3;	//Trace holds the pressed buttons, active high
+	}
+	for(i = 0; i < sim_press_count; i++)
+	{
+		if(sim_now >= sim_presses[i].at && sim_now < sim_presses[i].at + sim_hold)
+		{
+			buttons &= ~(1 << (sim_presses[i].button - 1));		//Buttons are active low
+		}
+	}
+	return buttons;
+}
+
+int hal_buttons_read(void)
+{
+	sim_step();
+	return sim_buttons();
+}
+
+int hal_switches_read(void)
+{
+	int switches = 0;
+	int i;
+
+	sim_step();
+	if(sim_trace)
+	{
+		return sim_trace_word() & 0x3FF;
+	}
+	for(i = 0; i < sim_switch_count; i++)
+	{
+		if(sim_now >= sim_switches[i].at)
+		{
+			switches = sim_switches[i].value;	//Latest change that has happened
+		}
+	}
+	return switches;
+}
+
+//Returns the echo pin levels at the current virtual time
+static int sim_echoes(void)
+{
+	int in = 0;
+	int i;
+
+	if(sim_fault == 2 && sim_now >= sim_fault_at)
+	{
+		return (1 << SIM_SENSORS) - 1;		//Echo inputs stuck high
+	}
+	for(i = 0; i < SIM_SENSORS; i++)
+	{
+		if(sim_now >= sim_echo_rise[i] && sim_now < sim_echo_fall[i])
+		{
+			in |= 1 << i;
+		}
+	}
+	return in;
+}
+
+int hal_header_read(void)
+{
+	alt_u64 edge = 0;
+	int i;
+
+	sim_step();
+	for(i = 0; sim_skip && i < SIM_SENSORS; i++)	//Earliest edge still to come
+	{
+		if(sim_echo_rise[i] > sim_now && (!edge || sim_echo_rise[i] < edge))
+		{
+			edge = sim_echo_rise[i];
+		}
+		else if(sim_echo_fall[i] > sim_now && sim_echo_rise[i] <= sim_now && (!edge || sim_echo_fall[i] < edge))
+		{
+			edge = sim_echo_fall[i];
+		}
+	}
+	if(edge)
+	{
+		sim_now = edge;
+	}
+	return sim_echoes();
+}
+
+void hal_sseg_write(int value)
+{
+	sim_step();
+	sim_sseg_writes++;
+	if(sim_pending)
+	{
+		sim_latency += sim_now - sim_pending;
+		sim_results++;
+		sim_pending = 0;
+	}
+	if(sim_verbose)
+	{
+		printf("%.6f sseg %08x\n", (double)sim_now / TIMESTAMP_TIMER_FREQ, (unsigned int)value);
+	}
+}
+
+void hal_leds_write(int value)
+{
+	sim_step();
+	sim_led_writes++;
+	if(sim_verbose)
+	{
+		printf("%.6f leds %03x\n", (double)sim_now / TIMESTAMP_TIMER_FREQ, (unsigned int)value);
+	}
+}
+
+void hal_header_set(int mask)
+{
+	alt_u64 fall = 0;
+	int i;
+
+	sim_step();
+	for(i = 0; i < SIM_SENSORS; i++)
+	{
+		if((mask >> i & 1) && !(sim_header_outs >> i & 1))
+		{
+			sim_trigger_at[i] = sim_now;	//Trigger rising edge
+		}
+		if(sim_echo_fall[i] <= sim_now && sim_echo_fall[i] > fall)
+		{
+			fall = sim_echo_fall[i];		//Latest echo that has ended
+		}
+	}
+	if(mask & ~sim_header_outs & ~((1 << SIM_SENSORS) - 1))		//Alarm pin turned on
+	{
+		alt_u64 latency = fall ? sim_now - fall : 0;
+
+		sim_alarms++;
+		sim_alarm_latency += latency;
+		if(latency > sim_alarm_worst)
+		{
+			sim_alarm_worst = latency;
+		}
+		if(sim_verbose)
+		{
+			printf("%.6f alarm %03x\n", (double)sim_now / TIMESTAMP_TIMER_FREQ, (unsigned int)(mask >> SIM_SENSORS));
+		}
+	}
+	sim_header_outs |= mask;
+}
+
+void hal_header_clear(int mask)
+{
+	int i;
+
+	sim_step();
+	for(i = 0; i < SIM_SENSORS; i++)
+	{
+		if((mask >> i & 1) && (sim_header_outs >> i & 1))
+		{
+			sim_srf05_trigger(i);			//Trigger falling edge
+		}
+	}
+	sim_header_outs &= ~mask;
+}
+
+#ifdef HAL_IRQ
+
+//Moves edge to at if at is still to come and sooner
+static void sim_sooner(alt_u64 *edge, alt_u64 at)
+{
+	if(at > sim_now && (!*edge || at < *edge))
+	{
+		*edge = at;
+	}
+}
+
+//Returns the time the next interrupting pin changes, 0 if none is known
+static alt_u64 sim_next_edge(void)
+{
+	alt_u64 edge = 0;
+	long row;
+	int i;
+
+	for(i = 0; i < SIM_SENSORS; i++)
+	{
+		sim_sooner(&edge, sim_echo_rise[i]);
+		sim_sooner(&edge, sim_echo_fall[i]);
+	}
+	if(sim_fault == 2)
+	{
+		sim_sooner(&edge, sim_fault_at);
+	}
+	for(i = 0; i < sim_press_count; i++)
+	{
+		sim_sooner(&edge, sim_presses[i].at);
+		sim_sooner(&edge, sim_presses[i].at + sim_hold);
+	}
+	for(row = sim_trace_input + 1; row < sim_trace_count; row++)
+	{
+		if(sim_trace[row].channel == SIM_TRACE_INPUT && sim_trace[row].at > sim_now)
+		{
+			sim_sooner(&edge, sim_trace[row].at);	//Rows are in time order, the first is the next
+			break;
+		}
+	}
+	return edge;
+}
+
+//Jumps the clock to the end of an idle wait, or to the next pin change that would interrupt it
+void hal_idle(alt_u64 ticks)
+{
+	alt_u64 until;
+	alt_u64 edge;
+
+	sim_step();
+	until = sim_now + ticks;
+	edge = sim_next_edge();
+	if(edge && edge < until)
+	{
+		until = edge;
+	}
+	sim_now = until < sim_end ? until : sim_end - 1;
+}
+
+//Takes an interrupt for each source whose enabled pins have changed since the last bus access
+static void sim_irq_check(void)
+{
+	int source;
+
+	if(sim_in_irq)
+	{
+		return;
+	}
+	for(source = 0; source < HAL_IRQ_SOURCES; source++)
+	{
+		alt_u32 level;
+
+		if(!sim_irq_fn[source])
+		{
+			continue;
+		}
+		level = (alt_u32)(source == HAL_IRQ_ECHO ? sim_echoes() : sim_buttons());
+		if((level ^ sim_irq_level[source]) & sim_irq_mask[source])
+		{
+			sim_in_irq = 1;
+			sim_irqs++;
+			sim_irq_fn[source](source, level, (alt_u32)(sim_now - sim_ts_base));
+			sim_in_irq = 0;
+		}
+		sim_irq_level[source] = level;
+	}
+}
+
+void hal_irq_enable(int source, alt_u32 mask, hal_irq_fn fn)
+{
+	sim_step();
+	sim_irq_level[source] = (alt_u32)(source == HAL_IRQ_ECHO ? sim_echoes() : sim_buttons());
+	sim_irq_mask[source] = mask;
+	sim_irq_fn[source] = fn;
+}
+
+#else
+
+//No interrupts in the polled build
+static void sim_irq_check(void)
+{
+}
+
+//Jumps the clock to the end of an idle wait, nothing can cut it short in the polled build
+void hal_idle(alt_u64 ticks)
+{
+	sim_step();
+	sim_now = sim_now + ticks < sim_end ? sim_now + ticks : sim_end - 1;
+}
+
+#endif
+
+int hal_timestamp_start(void)
+{
+	sim_step();
+	sim_ts_base = sim_now;
+	return 0;
+}
+
+alt_u32 hal_timestamp(void)
+{
+	sim_step();
+	return (alt_u32)(sim_now - sim_ts_base);
+}
+
+alt_u32 hal_timestamp_freq(void)
+{
+	return TIMESTAMP_TIMER_FREQ;
+}
+
+int hal_putstr(const char *str)
+{
+	sim_step();
+	if(sim_telemetry)
+	{
+		fputs(str, sim_telemetry);			//Text shares the UART with the binary bytes
+	}
+	return fputs(str, stdout);
+}
+
+int hal_console_read(void)
+{
+	sim_step();
+	if(sim_console_next >= sim_console_count || sim_now < sim_console[sim_console_next].at)
+	{
+		return -1;
+	}
+	if(!sim_console[sim_console_next].text[sim_console_pos])
+	{
+		sim_console_next++;					//Input finished, wait for the next one
+		sim_console_pos = 0;
+		return -1;
+	}
+	return (unsigned char)sim_console[sim_console_next].text[sim_console_pos++];
+}
+
+int hal_console_space(void)
+{
+	sim_step();
+	return sim_uart_space;					//Transmit FIFO is drained as fast as it is filled
+}
+
+void hal_console_write(int c)
+{
+	sim_step();
+	sim_console_bytes++;
+	if(sim_telemetry)
+	{
+		fputc(c & 0xFF, sim_telemetry);
+	}
+}
+
+//Allocates the flash on first use, erased or loaded from SIM_FLASH
+static void sim_flash_open(void)
+{
+	const char *path = getenv("SIM_FLASH");
+
+	if(sim_flash)
+	{
+		return;
+	}
+	sim_flash = malloc(SIM_FLASH_SIZE);
+	memset(sim_flash, 0xFF, SIM_FLASH_SIZE);
+	if(path)
+	{
+		sim_flash_file = fopen(path, "r+b");
+		if(!sim_flash_file)
+		{
+			sim_flash_file = fopen(path, "w+b");
+		}
+		if(sim_flash_file && fread(sim_flash, 1, SIM_FLASH_SIZE, sim_flash_file) != SIM_FLASH_SIZE)
+		{
+			fseek(sim_flash_file, 0, SEEK_SET);	//New or short file, write the whole erased flash
+			fwrite(sim_flash, 1, SIM_FLASH_SIZE, sim_flash_file);
+			fflush(sim_flash_file);
+		}
+	}
+}
+
+//Copies a changed part of the flash to the backing file
+static void sim_flash_sync(alt_u32 offset, int length)
+{
+	if(sim_flash_file)
+	{
+		fseek(sim_flash_file, offset, SEEK_SET);
+		fwrite(sim_flash + offset, 1, length, sim_flash_file);
+		fflush(sim_flash_file);
+	}
+}
+
+int hal_flash_read(alt_u32 offset, void *dest, int length)
+{
+	sim_step();
+	sim_flash_open();
+	if(offset + length > SIM_FLASH_SIZE)
+	{
+		return -1;
+	}
+	memcpy(dest, sim_flash + offset, length);
+	return 0;
+}
+
+int hal_flash_write(alt_u32 offset, const void *src, int length)
+{
+	const alt_u8 *data = src;
+	int i;
+
+	sim_step();
+	sim_flash_open();
+	if(offset + length > SIM_FLASH_SIZE)
+	{
+		return -1;
+	}
+	for(i = 0; i < length; i++)
+	{
+		sim_flash[offset + i] &= data[i];	//Programming can only clear bits
+	}
+	sim_flash_writes += length;
+	sim_flash_sync(offset, length);
+	return 0;
+}
+
+int hal_flash_erase(alt_u32 offset)
+{
+	sim_step();
+	sim_flash_open();
+	offset &= ~(alt_u32)(HAL_FLASH_SECTOR - 1);
+	if(offset >= SIM_FLASH_SIZE)
+	{
+		return -1;
+	}
+	memset(sim_flash + offset, 0xFF, HAL_FLASH_SECTOR);
+	sim_flash_erases++;
+	sim_flash_sync(offset, HAL_FLASH_SECTOR);
+	return 0;
+}
+
+#endif /* HOST_SIM */
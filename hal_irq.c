@@ -0,0 +1,61 @@
+/*
+ * 	Edge interrupts for the Hardware Abstraction Layer(hal.h) on the board.
+ *
+ * 	The header input and button PIOs must be built with "any edge" capture and an IRQ. The interrupt reads
+ * 	the timestamp counter first, so the time is taken as close to the edge as possible, then clears the edge
+ * 	capture register before reading the pins: an edge after the read is captured again and interrupts again.
+ */
+
+#ifndef HOST_SIM
+
+#include "hal.h"
+
+#ifdef HAL_IRQ
+
+#include "sys/alt_irq.h"					//for the interrupt registration
+
+typedef struct
+{
+	alt_u32 base;							//PIO base address
+	int source;								//HAL_IRQ_ source number
+	hal_irq_fn fn;							//Handler, 0 until enabled
+} hal_irq_pio;
+
+static hal_irq_pio pios[HAL_IRQ_SOURCES] =
+{
+	{HEADERINPUTS_BASE, HAL_IRQ_ECHO, 0},
+	{PUSHBUTTONS1_2_BASE, HAL_IRQ_BUTTONS, 0}
+};
+
+//Timestamps an edge and passes the pin levels to the handler
+static void hal_irq_isr(void *context)
+{
+	hal_irq_pio *pio = (hal_irq_pio *)context;
+	alt_u32 stamp = (alt_u32)alt_timestamp();
+
+	IOWR_ALTERA_AVALON_PIO_EDGE_CAP(pio->base, 0xFFFFFFFF);
+	pio->fn(pio->source, (alt_u32)IORD_ALTERA_AVALON_PIO_DATA(pio->base), stamp);
+	IORD_ALTERA_AVALON_PIO_EDGE_CAP(pio->base);		//Read back so the clear reaches the PIO before returning
+}
+
+//Calls fn from the interrupt on any edge of the pins in mask
+void hal_irq_enable(int source, alt_u32 mask, hal_irq_fn fn)
+{
+	hal_irq_pio *pio = &pios[source];
+
+	pio->fn = fn;
+	IOWR_ALTERA_AVALON_PIO_EDGE_CAP(pio->base, 0xFFFFFFFF);
+	if(source == HAL_IRQ_ECHO)
+	{
+		alt_ic_isr_register(HEADERINPUTS_IRQ_INTERRUPT_CONTROLLER_ID, HEADERINPUTS_IRQ, hal_irq_isr, pio, 0);
+	}
+	else
+	{
+		alt_ic_isr_register(PUSHBUTTONS1_2_IRQ_INTERRUPT_CONTROLLER_ID, PUSHBUTTONS1_2_IRQ, hal_irq_isr, pio, 0);
+	}
+	IOWR_ALTERA_AVALON_PIO_IRQ_MASK(pio->base, mask);
+}
+
+#endif /* HAL_IRQ */
+
+#endif /* HOST_SIM */
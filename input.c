@@ -0,0 +1,124 @@
+/*
+ * 	Debounced switch and button input, see input.h.
+ *
+ * 	Both registers are packed into one word, switches in bits 0 to 9 and the pressed buttons(active high)
+ * 	in bits 10 and 11, so one compare finds any change and one timer debounces both.
+ * 	With edge interrupts every button edge also restarts the stable time at the time it happened, so a
+ * 	bounce that comes and goes between two reads is not mistaken for a stable button.
+ */
+
+#include "hal.h"
+#include "input.h"
+#include "sched.h"
+#include "edges.h"
+
+static input_fn handler = 0;				//Called for every event
+static int task = -1;						//Scheduler task id
+static alt_u32 stable = 0;					//Last accepted packed value
+static alt_u32 raw = 0;						//Last read packed value
+static alt_u64 raw_since = 0;				//Time the read value last changed
+static input_settings settings;				//Decoded snapshot of stable
+
+//Reads both registers into one packed word
+static alt_u32 input_read(void)
+{
+	alt_u32 switches = (alt_u32)hal_switches_read() & 0x3FF;			//Read Switch states
+	alt_u32 buttons = ~(alt_u32)hal_buttons_read() & 0x3;				//Read button states, active low
+
+	return switches | (buttons << INPUT_BUTTONS_SHIFT);
+}
+
+//Decodes a packed word into the snapshot
+static void input_decode(alt_u32 value)
+{
+	settings.CR = value & 1;
+	settings.CM_M = (value >> 1) & 1;
+	settings.LED = (value >> 2) & 1;
+	settings.DP = (value >> 3) & 1;
+	settings.LOAD = (value >> 4) & 1;
+	settings.SV = (value >> 5) & 0x1F;
+	settings.buttons = (value >> INPUT_BUTTONS_SHIFT) & 0x3;
+}
+
+//Reads the registers and reports any change that has been stable for INPUT_DEBOUNCE
+static void input_task(void)
+{
+	alt_u32 value = input_read();
+	alt_u32 changed;
+	alt_u32 pressed;
+	alt_u32 released;
+	edges_event event;
+
+	sched_wake(task, INPUT_PERIOD);
+
+	while(edges_pop(EDGES_BUTTONS, &event))	//Button edges seen by the interrupt
+	{
+		if(event.time > raw_since)
+		{
+			raw_since = event.time;
+		}
+	}
+
+	if(value != raw)						//Still bouncing, start the stable time again
+	{
+		raw = value;
+		raw_since = timebase_now();
+		return;
+	}
+	if(value == stable || timebase_elapsed(raw_since) < INPUT_DEBOUNCE)
+	{
+		return;
+	}
+
+	changed = (value ^ stable) & 0x3FF;
+	pressed = (value & ~stable) >> INPUT_BUTTONS_SHIFT;
+	released = (stable & ~value) >> INPUT_BUTTONS_SHIFT;
+	stable = value;
+	input_decode(stable);
+
+	if(changed)
+	{
+		handler(INPUT_SWITCH, (int)changed);
+	}
+	if(pressed & 0x1)
+	{
+		handler(INPUT_PRESS, 1);
+	}
+	if(pressed & 0x2)
+	{
+		handler(INPUT_PRESS, 2);
+	}
+	if(released & 0x1)
+	{
+		handler(INPUT_RELEASE, 1);
+	}
+	if(released & 0x2)
+	{
+		handler(INPUT_RELEASE, 2);
+	}
+}
+
+//Takes the first snapshot without reporting it and adds the input task to the scheduler
+void input_init(input_fn new_handler)
+{
+	handler = new_handler;
+	raw = input_read() & 0x3FF;				//Buttons held at power on are reported once debounced
+	raw_since = timebase_now();
+	stable = raw;
+	input_decode(stable);
+
+	task = sched_add(input_task);
+	sched_wake(task, 0);
+}
+
+//Returns the latest debounced snapshot
+const input_settings *input_get(void)
+{
+	return &settings;
+}
+
+//Returns the latest debounced snapshot packed into one word
+alt_u32 input_word(void)
+{
+	return stable;
+}
@@ -0,0 +1,56 @@
+/*
+ * 	Debounced switch and button input.
+ *
+ * 	A scheduler task snapshots the switch and button registers every INPUT_PERIOD. A new value is only
+ * 	accepted once it has been stable for INPUT_DEBOUNCE, which removes contact bounce from both. Each
+ * 	accepted change is decoded once into an input_settings snapshot and reported to the handler as events:
+ * 	INPUT_PRESS and INPUT_RELEASE for every button that has just been pressed or let go and INPUT_SWITCH
+ * 	with a mask of the switches that have just changed. When nothing changes the task does nothing but the
+ * 	two register reads. input_word() gives the snapshot packed into one word, as recorded in traces.
+ *
+ *	<Switch bits>
+ *	SW0 = CR, SW1 = CM_M, SW2 = LED, SW3 = DP, SW4 = LOAD, SW5 to SW9 = save slots 1 to 5
+ *	<END>>>
+ */
+
+#ifndef INPUT_H_
+#define INPUT_H_
+
+#include "timebase.h"
+
+#define INPUT_PERIOD	TIMEBASE_MS(1)		//Registers are read every 1ms
+#define INPUT_DEBOUNCE	TIMEBASE_MS(20)		//Time a new value must be stable for
+
+#define INPUT_SW_CR		0x001				//Switch masks for INPUT_SWITCH events
+#define INPUT_SW_CM_M	0x002
+#define INPUT_SW_LED	0x004
+#define INPUT_SW_DP		0x008
+#define INPUT_SW_LOAD	0x010
+#define INPUT_SW_SV		0x3E0
+#define INPUT_BUTTONS_SHIFT	10				//Position of the pressed buttons in input_word()
+
+typedef enum
+{
+	INPUT_PRESS,							//A button has been pressed, which = 1 or 2
+	INPUT_RELEASE,							//A button has been let go, which = 1 or 2
+	INPUT_SWITCH							//Switches have changed, which = mask of the switches
+} input_event;
+
+typedef struct
+{
+	unsigned int CR : 1;					//Constant read(SW0)
+	unsigned int CM_M : 1;					//CM or M(SW1)
+	unsigned int LED : 1;					//LEDs on(SW2)
+	unsigned int DP : 1;					//Decimal point(SW3)
+	unsigned int LOAD : 1;					//Load or Save(SW4)
+	unsigned int SV : 5;					//Save slots 1 to 5(SW5 to SW9), slot n in bit n - 1
+	unsigned int buttons : 2;				//Buttons held down, button n in bit n - 1
+} input_settings;
+
+typedef void (*input_fn)(input_event event, int which);
+
+void input_init(input_fn handler);			//Takes the first snapshot and adds the input task to the scheduler
+const input_settings *input_get(void);		//Latest debounced snapshot
+alt_u32 input_word(void);					//Latest debounced snapshot packed, switches in bits 0 to 9, buttons in 10 and 11
+
+#endif /* INPUT_H_ */
@@ -0,0 +1,161 @@
+/*
+ * 	Sample logger, see logger.h.
+ *
+ * 	The log is a plain array, the DE0 design links .bss into the SDRAM so it lands there without a
+ * 	special section. LOGGER_SIZE can be lowered with -D for designs with less memory.
+ */
+
+#include "logger.h"
+#include "telemetry.h"
+#include "console.h"
+#include "sched.h"
+
+static alt_u8 buffer[LOGGER_SIZE];					//Packed records
+static alt_u32 length = 0;							//Bytes used
+static alt_u32 samples = 0;							//Records in the log
+static alt_u32 lost = 0;							//Samples dropped because the log was full
+static int enabled = 0;								//1 while a capture is running
+
+static alt_u64 last_time = 0;						//Time of the last record
+static int last_ticks[LOGGER_CHANNELS];				//Echo length of each channel's last record
+
+static int task = -1;								//Scheduler task id
+static alt_u32 dump_offset = 0;						//Next byte to dump
+static alt_u32 dump_length = 0;						//Bytes being dumped
+static int dumping = 0;								//1 while a dump is running
+
+//Zigzag encodes a signed difference so small negative values stay short
+static alt_u64 logger_zigzag(alt_64 value)
+{
+	return (alt_u64)((value << 1) ^ (value >> 63));
+}
+
+//Starts a new capture or stops the current one
+void logger_enable(int on)
+{
+	int channel;
+
+	if(on && !enabled)
+	{
+		length = 0;
+		samples = 0;
+		lost = 0;
+		last_time = 0;
+		for(channel = 0; channel < LOGGER_CHANNELS; channel++)
+		{
+			last_ticks[channel] = 0;
+		}
+	}
+	enabled = on;
+}
+
+//Returns 1 while a capture is running
+int logger_enabled(void)
+{
+	return enabled;
+}
+
+//Adds a sample to the capture
+void logger_add(alt_u64 time, int channel, int error, int ticks)
+{
+	alt_u8 record[24];
+	int used;
+	int i;
+
+	if(!enabled)
+	{
+		return;
+	}
+	channel &= LOGGER_CHANNELS - 1;
+	used = telemetry_varint(record, logger_zigzag((alt_64)(time - last_time)));
+	record[used++] = (alt_u8)((channel << 4) | (error & 0x0F));
+	used += telemetry_varint(&record[used], logger_zigzag((alt_64)ticks - last_ticks[channel]));
+
+	if(length + used > LOGGER_SIZE)
+	{
+		lost++;
+		return;
+	}
+	for(i = 0; i < used; i++)
+	{
+		buffer[length++] = record[i];
+	}
+	last_time = time;
+	last_ticks[channel] = ticks;
+	samples++;
+}
+
+//Returns the number of samples in the capture
+alt_u32 logger_samples(void)
+{
+	return samples;
+}
+
+//Returns the number of bytes used by the capture
+alt_u32 logger_bytes(void)
+{
+	return length;
+}
+
+//Queues the next dump frames while the telemetry ring has room, then the end frame
+static void logger_task(void)
+{
+	alt_u8 payload[LOGGER_CHUNK + 8];
+	alt_u32 chunk;
+	alt_u32 i;
+	int used;
+
+	while(dumping)
+	{
+		chunk = dump_length - dump_offset > LOGGER_CHUNK ? LOGGER_CHUNK : dump_length - dump_offset;
+		used = telemetry_varint(payload, dump_offset);
+		for(i = 0; i < chunk; i++)
+		{
+			payload[used + i] = buffer[dump_offset + i];
+		}
+		if(chunk == 0)								//End frame, the total length and the tick rate of the times
+		{
+			used += telemetry_varint(&payload[used], TIMING_HZ);
+		}
+		if(!telemetry_frame(chunk ? LOGGER_SYNC : LOGGER_END_SYNC, payload, used + (int)chunk))
+		{
+			sched_wake(task, LOGGER_PERIOD);		//Ring full, try again once some has been sent
+			return;
+		}
+		dump_offset += chunk;
+		dumping = chunk != 0;
+	}
+}
+
+//Starts or stops a capture from the console
+static void logger_toggle(void)
+{
+	logger_enable(!enabled);
+	console_put(enabled ? "log on\n" : "log off\n");
+	console_put_line("samples", samples);
+	console_put_line("bytes", length);
+	console_put_line("lost", lost);
+}
+
+//Dumps the capture from the console, the samples so far if it is still running
+static void logger_dump(void)
+{
+	if(dumping)
+	{
+		console_put("dump already running\n");
+		return;
+	}
+	console_put_line("dump bytes", length);
+	dump_offset = 0;
+	dump_length = length;							//Samples added during the dump are not sent
+	dumping = 1;
+	sched_wake(task, 0);
+}
+
+//Adds the dump task and console commands
+void logger_init(void)
+{
+	task = sched_add(logger_task);
+	console_add('l', logger_toggle, "log capture start/stop");
+	console_add('d', logger_dump, "dump the log capture");
+}
@@ -0,0 +1,54 @@
+/*
+ * 	Sample logger, records every raw reading into a large buffer in SDRAM for long captures.
+ *
+ * 	Each sensor result is packed as it arrives: the time as a zigzag varint difference from the previous
+ * 	record, a channel << 4 | error byte and the echo length as a zigzag varint difference from that
+ * 	channel's previous echo. At a steady rate this is about 5 bytes a sample instead of 13, so the default
+ * 	2MB holds well over an hour of constant read. Packing a record is a few shifts and stores, so ranging
+ * 	is not slowed. When the buffer is full new samples are counted and dropped, the capture is kept.
+ *
+ * 	'l' starts a new capture or stops the current one, 'd' dumps it over the JTAG UART. The dump is sent in
+ * 	LOGGER_CHUNK sized frames through the telemetry ring(telemetry.h) in the background, followed by an
+ * 	end frame holding the total length and the timestamp frequency the times were taken with.
+ * 	tools/log_decode.c turns a dump back into the same CSV as tools/telemetry_decode, so a capture can also
+ * 	be replayed with SIM_TRACE.
+ *
+ *	<Dump Frame>
+ *	0x5A, length, payload, Fletcher-16 of length and payload(2 bytes)
+ *	payload = varint offset of the first byte in the log, then the log bytes
+ *	<END>>>
+ *
+ *	<End Frame>
+ *	0x5B, length, payload, Fletcher-16 of length and payload(2 bytes)
+ *	payload = varint total length of the log, varint TIMING_HZ
+ *	<END>>>
+ *
+ *	<Log Record>
+ *	zigzag varint time since the previous record(the first record holds the full time)
+ *	channel << 4 | error
+ *	zigzag varint echo length less the channel's previous echo length
+ *	<END>>>
+ */
+
+#ifndef LOGGER_H_
+#define LOGGER_H_
+
+#include "timebase.h"
+
+#ifndef LOGGER_SIZE
+#define LOGGER_SIZE		0x200000					//Bytes of SDRAM used for the log
+#endif
+#define LOGGER_SYNC		0x5A						//First byte of a dump frame
+#define LOGGER_END_SYNC	0x5B						//First byte of the end frame
+#define LOGGER_CHUNK	200							//Log bytes per dump frame
+#define LOGGER_PERIOD	TIMEBASE_MS(1)				//Dump frames are queued every 1ms
+#define LOGGER_CHANNELS	16							//Channels with their own echo difference
+
+void logger_init(void);								//Adds the dump task and console commands
+void logger_enable(int on);							//Starts a new capture or stops the current one
+int logger_enabled(void);							//1 while a capture is running
+void logger_add(alt_u64 time, int channel, int error, int ticks);	//Adds a sample to the capture
+alt_u32 logger_samples(void);						//Samples in the capture
+alt_u32 logger_bytes(void);							//Bytes used by the capture
+
+#endif /* LOGGER_H_ */
@@ -0,0 +1,146 @@
+/*
+ * 	Output driver for the SSEG display, the LEDs and the header output pins, see output.h.
+ */
+
+#include "output.h"
+#include "sseg.h"
+#include "console.h"
+
+//LED bargraph for each 1000 counts of distance, (distance - 1) / 1000
+static const alt_u16 output_bars[10] =
+{
+	0x000,		//Distance <= 1000, NO LEDs are Lit
+	0x001,		//Distance <= 2000, LED 0 is lit
+	0x003,		//Distance <= 3000, LED 0:1 is lit
+	0x007,		//Distance <= 4000, LED 0:2 is lit
+	0x00F,		//Distance <= 5000, LED 0:3 is lit
+	0x01F,		//Distance <= 6000, LED 0:4 is lit
+	0x03F,		//Distance <= 7000, LED 0:5 is lit
+	0x07F,		//Distance <= 8000, LED 0:6 is lit
+	0x0FF,		//Distance <= 9000, LED 0:7 is lit
+	0x1FF		//Distance < 10000, LED 0:8 is lit
+};
+
+static const char *const output_names[OUTPUT_REGS] = {"sseg", "leds", "header"};
+
+static int shadow[OUTPUT_REGS];					//Value last written to each register
+static alt_u32 writes[OUTPUT_REGS];				//Bus writes made
+static alt_u32 skips[OUTPUT_REGS];				//Writes skipped
+
+//Prints the writes made and skipped for each register
+static void output_report(void)
+{
+	int reg;
+
+	for(reg = 0; reg < OUTPUT_REGS; reg++)
+	{
+		console_put(output_names[reg]);
+		console_put_line(" writes", output_writes((output_reg)reg));
+		console_put(output_names[reg]);
+		console_put_line(" skips", output_skips((output_reg)reg));
+	}
+}
+
+//Writes every register once so the shadow copies are known and adds the console command
+void output_init(void)
+{
+	shadow[OUTPUT_SSEG] = SSEG_BLANK_WORD;
+	hal_sseg_write(SSEG_BLANK_WORD);
+	shadow[OUTPUT_LEDS] = 0;
+	hal_leds_write(0);
+	shadow[OUTPUT_HEADER] = 0;
+	hal_header_clear(~0);
+	writes[OUTPUT_SSEG]++;
+	writes[OUTPUT_LEDS]++;
+	writes[OUTPUT_HEADER]++;
+	console_add('w', output_report, "output writes made and skipped");
+}
+
+//Writes the SSEG display if the word has changed
+void output_sseg(int word)
+{
+	if(word == shadow[OUTPUT_SSEG])
+	{
+		skips[OUTPUT_SSEG]++;
+		return;
+	}
+	shadow[OUTPUT_SSEG] = word;
+	hal_sseg_write(word);
+	writes[OUTPUT_SSEG]++;
+}
+
+//Writes the LEDs in mask if any of them has changed
+void output_leds_field(int mask, int value)
+{
+	int leds = (shadow[OUTPUT_LEDS] & ~mask) | (value & mask);
+
+	if(leds == shadow[OUTPUT_LEDS])
+	{
+		skips[OUTPUT_LEDS]++;
+		return;
+	}
+	shadow[OUTPUT_LEDS] = leds;
+	hal_leds_write(leds);
+	writes[OUTPUT_LEDS]++;
+}
+
+//Writes all the LEDs if they have changed
+void output_leds(int value)
+{
+	output_leds_field(~0, value);
+}
+
+//Lights one LED per 1000 counts of distance, the LEDs are left as they are from 10000
+void output_bargraph(int distance)
+{
+	if(distance <= 0)
+	{
+		output_leds_field(OUTPUT_BAR_LEDS, output_bars[0]);
+	}
+	else if(distance < 10000)
+	{
+		output_leds_field(OUTPUT_BAR_LEDS, output_bars[((alt_u32)(distance - 1) * 8389) >> 23]);	//(distance - 1) / 1000 without a divide
+	}
+}
+
+//Turns on the header output pins in mask that are off
+void output_header_set(int mask)
+{
+	int changed = mask & ~shadow[OUTPUT_HEADER];
+
+	if(!changed)
+	{
+		skips[OUTPUT_HEADER]++;
+		return;
+	}
+	shadow[OUTPUT_HEADER] |= changed;
+	hal_header_set(changed);
+	writes[OUTPUT_HEADER]++;
+}
+
+//Turns off the header output pins in mask that are on
+void output_header_clear(int mask)
+{
+	int changed = mask & shadow[OUTPUT_HEADER];
+
+	if(!changed)
+	{
+		skips[OUTPUT_HEADER]++;
+		return;
+	}
+	shadow[OUTPUT_HEADER] &= ~changed;
+	hal_header_clear(changed);
+	writes[OUTPUT_HEADER]++;
+}
+
+//Returns the number of bus writes made to a register
+alt_u32 output_writes(output_reg reg)
+{
+	return writes[reg];
+}
+
+//Returns the number of writes skipped as the register already held the value
+alt_u32 output_skips(output_reg reg)
+{
+	return skips[reg];
+}
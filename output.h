@@ -0,0 +1,42 @@
+/*
+ * 	Output driver for the SSEG display, the LEDs and the header output pins.
+ *
+ * 	A shadow copy of each output register is kept, and a write that would not change the register is
+ * 	skipped instead of going out on the bus. Parts of a register can be changed with a mask, which
+ * 	updates the shadow copy and writes the result, so there is never a read-modify-write on the bus.
+ * 	The number of writes made and skipped for each register is counted.
+ *
+ *	<Console Commands>
+ *	w		//Prints the writes made and skipped for each register
+ *	<END>>>
+ *
+ * 	The header outputs are changed through the PIO's outset and outclear registers, so only the pins
+ * 	that actually change are written.
+ */
+
+#ifndef OUTPUT_H_
+#define OUTPUT_H_
+
+#include "hal.h"
+
+#define OUTPUT_BAR_LEDS		0x1FF				//LEDs 0 to 8 show the bargraph, LED 9 is left for alarms
+
+typedef enum
+{
+	OUTPUT_SSEG,
+	OUTPUT_LEDS,
+	OUTPUT_HEADER,
+	OUTPUT_REGS									//Number of registers
+} output_reg;
+
+void output_init(void);							//Writes every register once so the shadow copies are known, adds the console command
+void output_sseg(int word);						//Writes the SSEG display
+void output_leds(int value);					//Writes all the LEDs
+void output_leds_field(int mask, int value);	//Writes the LEDs in mask, leaving the others as they are
+void output_bargraph(int distance);				//Lights one LED per 1000 counts of distance, below 10000
+void output_header_set(int mask);				//Turns on header output pins in mask
+void output_header_clear(int mask);				//Turns off header output pins in mask
+alt_u32 output_writes(output_reg reg);			//Number of bus writes made to a register
+alt_u32 output_skips(output_reg reg);			//Number of writes skipped as the register already held the value
+
+#endif /* OUTPUT_H_ */
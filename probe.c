@@ -0,0 +1,122 @@
+/*
+ * 	Timing probes for the stages of a reading, see probe.h.
+ */
+
+#include "probe.h"
+
+#ifdef PROBES
+
+#include "console.h"
+
+typedef struct
+{
+	alt_u32 count;
+	alt_u32 min;
+	alt_u32 max;
+	alt_u64 sum;
+	alt_u32 buckets[PROBE_BUCKETS];				//Bucket n holds times from 2^n to 2^(n+1) - 1, bucket 0 also holds 0
+} probe_data;
+
+static const char *const names[PROBES_COUNT] =
+{
+	"holdoff",
+	"trigger",
+	"rise",
+	"echo",
+	"filter",
+	"convert",
+	"leds",
+	"render",
+	"result",
+	"log",
+	"track"
+};
+
+static probe_data probes[PROBES_COUNT];
+
+//Adds a time to a probe
+void probe_add(probe_id id, alt_u32 ticks)
+{
+	probe_data *probe = &probes[id];
+	int bucket = 0;
+
+	while((ticks >> bucket) > 1 && bucket < PROBE_BUCKETS - 1)	//log2 of the time
+	{
+		bucket++;
+	}
+	probe->buckets[bucket]++;
+
+	if(probe->count == 0 || ticks < probe->min)
+	{
+		probe->min = ticks;
+	}
+	if(ticks > probe->max)
+	{
+		probe->max = ticks;
+	}
+	probe->sum += ticks;
+	probe->count++;
+}
+
+//Clears every probe
+void probe_reset(void)
+{
+	int id, bucket;
+
+	for(id = 0; id < PROBES_COUNT; id++)
+	{
+		probes[id].count = 0;
+		probes[id].min = 0;
+		probes[id].max = 0;
+		probes[id].sum = 0;
+		for(bucket = 0; bucket < PROBE_BUCKETS; bucket++)
+		{
+			probes[id].buckets[bucket] = 0;
+		}
+	}
+}
+
+//Prints every probe that has been used, times in ticks
+void probe_dump(void)
+{
+	int id, bucket;
+
+	console_put("probe count min max mean, then log2 bucket:count\n");
+	for(id = 0; id < PROBES_COUNT; id++)
+	{
+		if(probes[id].count == 0)
+		{
+			continue;
+		}
+		console_put(names[id]);
+		console_put(" ");
+		console_put_u32(probes[id].count);
+		console_put(" ");
+		console_put_u32(probes[id].min);
+		console_put(" ");
+		console_put_u32(probes[id].max);
+		console_put(" ");
+		console_put_u32((alt_u32)(probes[id].sum / probes[id].count));
+		console_put("\n ");
+		for(bucket = 0; bucket < PROBE_BUCKETS; bucket++)
+		{
+			if(probes[id].buckets[bucket])
+			{
+				console_put(" ");
+				console_put_u32(bucket);
+				console_put(":");
+				console_put_u32(probes[id].buckets[bucket]);
+			}
+		}
+		console_put("\n");
+	}
+}
+
+//Adds the console commands
+void probe_init(void)
+{
+	console_add('p', probe_dump, "print timing probes");
+	console_add('P', probe_reset, "clear timing probes");
+}
+
+#endif /* PROBES */
@@ -0,0 +1,59 @@
+/*
+ * 	Timing probes for the stages of a reading.
+ *
+ * 	Each probe collects the count, minimum, maximum and total of the times added to it, in timestamp
+ * 	ticks, and a histogram with one bucket per power of two. Everything is in fixed size arrays.
+ * 	The 'p' console command prints every probe and 'P' clears them.
+ *
+ * 	Probes are only built when PROBES is defined. Otherwise the PROBE_ macros are empty and the probes
+ * 	cost nothing, so they can be left in the code. They work the same on the board and in the host
+ * 	simulation, where the times are in virtual ticks.
+ *
+ * 	PROBE_BEGIN(id) and PROBE_END(id) time the code between them and must be in the same block.
+ * 	PROBE_ADD(id, ticks) adds a time measured some other way, such as the length of a state.
+ */
+
+#ifndef PROBE_H_
+#define PROBE_H_
+
+#include "hal.h"
+
+#define PROBE_BUCKETS	24						//Histogram buckets, the last also holds longer times
+
+typedef enum
+{
+	PROBE_HOLDOFF,								//Trigger held off by the cadence
+	PROBE_TRIGGER,								//Trigger pulse
+	PROBE_RISE,									//End of the trigger to the start of the echo
+	PROBE_ECHO,									//Echo length
+	PROBE_FILTER,								//Constant read filter
+	PROBE_CONVERT,								//Ticks to distance conversion
+	PROBE_LEDS,									//LED bargraph update
+	PROBE_RENDER,								//SSEG display word rendering
+	PROBE_RESULT,								//Finished reading to display written
+	PROBE_LOG,									//Packing a sample into the log
+	PROBE_TRACK,								//Tracker fit
+	PROBES_COUNT								//Number of probes
+} probe_id;
+
+#ifdef PROBES
+
+#define PROBE_BEGIN(id)		alt_u32 probe_begin_##id = hal_timestamp()
+#define PROBE_END(id)		probe_add((id), hal_timestamp() - probe_begin_##id)
+#define PROBE_ADD(id,ticks)	probe_add((id), (alt_u32)(ticks))
+
+void probe_init(void);							//Adds the console commands
+void probe_add(probe_id id, alt_u32 ticks);		//Adds a time to a probe
+void probe_reset(void);							//Clears every probe
+void probe_dump(void);							//Prints every probe to the console
+
+#else
+
+#define PROBE_BEGIN(id)
+#define PROBE_END(id)
+#define PROBE_ADD(id,ticks)
+#define probe_init()
+
+#endif /* PROBES */
+
+#endif /* PROBE_H_ */
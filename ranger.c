@@ -0,0 +1,444 @@
+/*
+ * 	Non-blocking ranging engine for one or more SRF05 Ultrasonic Range Finders, see ranger.h.
+ *
+ * 	Each waiting state sets a deadline on the 64-bit time base when it is entered, the timestamp
+ * 	counter itself is never restarted.
+ *
+ * 	While echoes are being timed the sensors of the group are tracked as bit masks: waiting holds the
+ * 	sensors whose echo has not started and high those whose echo is in progress. One read of the input
+ * 	register gives the edges of every sensor, and the per sensor loop only runs when an edge was seen
+ * 	or a deadline has passed.
+ *
+ * 	With edge interrupts(HAL_IRQ) the input register is not polled: the same edge handling runs once for
+ * 	each queued edge at the time its interrupt was taken, then once more at the current time for the deadlines.
+ * 	ranger_wait() then lets the caller sleep until the next deadline, as an edge signals it sooner.
+ *
+ * 	The alarm zones(alarm.h) are checked against the raw echo as soon as it ends, before anything else. While
+ * 	an echo is high the length that turns its next zone off is a deadline like the stuck echo timeout.
+ */
+
+#include "hal.h"
+#include "ranger.h"
+#include "timebase.h"
+#include "cadence.h"
+#include "output.h"
+#include "probe.h"
+#include "edges.h"
+#include "calib.h"
+#include "alarm.h"
+#include "console.h"
+
+static ranger_state state = RANGER_IDLE;	//Current state of the reading
+static alt_u64 deadline = 0;				//Time the hold off, trigger pulse or echo start wait ends
+
+static alt_u32 groups[RANGER_CHANNELS] = {RANGER_ALL};	//Trigger groups, all sensors together by default
+static int group_count = 1;
+static int group = 0;						//Group being measured
+static alt_u32 firing = 0;					//Sensors triggered by this attempt
+static alt_u32 waiting = 0;					//Sensors whose echo has not started
+static alt_u32 high = 0;					//Sensors whose echo is in progress
+static alt_u64 echo_deadline = 0;			//Time an echo in progress next turns off an alarm zone or becomes too long
+#ifdef HAL_IRQ
+static alt_u32 level = 0;					//Echo pin levels from the latest queued edge
+#endif
+
+static alt_u64 rise[RANGER_CHANNELS];		//Time each echo started
+static int raw[RANGER_CHANNELS];			//Echo length of each sensor as measured
+static int result[RANGER_CHANNELS];			//Echo length of each sensor after calibration
+static ranger_err error[RANGER_CHANNELS];	//Result of each sensor
+static int nearest = 0;						//Sensor with the shortest echo
+
+static int retries = RANGER_RETRIES;		//Retries allowed per group
+static int attempt = 0;						//Retries used by the current group
+static alt_u32 errors[RANGER_ERRORS];		//Error counters
+
+TIMING_CHECK(echo_fits_int, RANGER_ECHO_TIMEOUT < 0x7FFFFFFF);	//Echo lengths are ints
+
+#ifdef PROBES
+static alt_u64 holdoff_start = 0;			//Time the hold off started, for the probes
+#endif
+
+//Reports the error counters and sets the retries from the number typed before the command, if any
+static void ranger_report(void)
+{
+	alt_32 value;
+
+	if(console_arg(&value))
+	{
+		if(value < 0 || value > RANGER_MAX_RETRIES)
+		{
+			console_put("retries are 0 to 8\n");
+			return;
+		}
+		ranger_retries((int)value);
+	}
+	console_put_line("retries", retries);
+	console_put_line("Err.1 no echo", ranger_error_count(RANGER_NO_ECHO));
+	console_put_line("Err.2 echo too long", ranger_error_count(RANGER_ECHO_LONG));
+	console_put_line("Err.3 out of range", ranger_error_count(RANGER_OUT_OF_RANGE));
+}
+
+//Sets the trigger groups from the number typed before the command, 0 for every sensor together, 1 for one at a time
+static void ranger_groups(void)
+{
+	alt_u32 pattern[RANGER_CHANNELS];
+	alt_32 value;
+	int channel;
+
+	if(!console_arg(&value) || value < 0 || value > 1)
+	{
+		console_put("type 0 for together or 1 for one at a time before the command\n");
+		return;
+	}
+	for(channel = 0; channel < RANGER_CHANNELS; channel++)
+	{
+		pattern[channel] = value ? 1u << channel : RANGER_ALL;
+	}
+	ranger_pattern(pattern, value ? RANGER_CHANNELS : 1);
+	console_put_line("groups", group_count);
+}
+
+//Turns the triggers off and adds the console commands
+void ranger_init(void)
+{
+	output_header_clear(RANGER_ALL);		//Turns off the trigger outputs
+	state = RANGER_IDLE;
+	console_add('e', ranger_report, "<n>e sensor error counts, n sets the retries");
+	console_add('g', ranger_groups, "<n>g trigger the sensors 0 together, 1 one at a time");
+}
+
+//Sets how many times a failed reading is retried
+void ranger_retries(int new_retries)
+{
+	retries = new_retries < 0 ? 0 : new_retries;
+}
+
+//Sets the trigger groups of a sweep, in order
+void ranger_pattern(const alt_u32 *new_groups, int count)
+{
+	int i;
+
+	group_count = 0;
+	for(i = 0; i < count && group_count < RANGER_CHANNELS; i++)
+	{
+		if(new_groups[i] & RANGER_ALL)
+		{
+			groups[group_count++] = new_groups[i] & RANGER_ALL;
+		}
+	}
+	if(group_count == 0)
+	{
+		groups[group_count++] = RANGER_ALL;
+	}
+}
+
+//Waits for the cadence to allow the next trigger
+static void ranger_holdoff(void)
+{
+	output_header_clear(RANGER_ALL);		//Turns off the trigger outputs
+	deadline = cadence_next();
+	state = RANGER_HOLDOFF;
+#ifdef PROBES
+	holdoff_start = timebase_now();
+#endif
+}
+
+//Counts an error for one sensor
+static void ranger_fail(int channel, ranger_err err)
+{
+	errors[err]++;
+	error[channel] = err;
+}
+
+//Retries the failed sensors of the group, moves to the next group or ends the sweep
+static void ranger_group_done(void)
+{
+	alt_u32 retry = 0;
+	int channel;
+
+	for(channel = 0; channel < RANGER_CHANNELS; channel++)
+	{
+		if((firing >> channel) & 1 && (error[channel] == RANGER_NO_ECHO || error[channel] == RANGER_ECHO_LONG))
+		{
+			retry |= 1u << channel;
+		}
+	}
+
+	if(retry && attempt < retries)			//Try the sensors that did not answer again
+	{
+		attempt++;
+		firing = retry;
+		ranger_holdoff();
+		return;
+	}
+
+	if(++group < group_count)				//Next group of the sweep
+	{
+		attempt = 0;
+		firing = groups[group];
+		ranger_holdoff();
+		return;
+	}
+
+	nearest = -1;							//Sweep finished, find the nearest sensor
+	for(channel = 0; channel < RANGER_CHANNELS; channel++)
+	{
+		if(error[channel] == RANGER_OK && (nearest < 0 || result[channel] < result[nearest]))
+		{
+			nearest = channel;
+		}
+	}
+	if(nearest < 0)
+	{
+		nearest = 0;
+		state = RANGER_ERROR;
+	}
+	else
+	{
+		state = RANGER_DONE;
+	}
+}
+
+//Finds the echo edges and timeouts of every sensor in the group from the input pins at one time
+static void ranger_edges(alt_u32 in, alt_u64 now)
+{
+	alt_u32 rose = in & waiting;				//Echoes that have just started
+	alt_u32 fell = ~in & high;					//Echoes that have just ended
+	alt_u32 late = (waiting && now >= deadline) ? waiting & ~rose : 0;	//Echoes that never started
+	alt_u32 check = (high && now >= echo_deadline) ? high & ~fell : 0;	//Echoes that may be past a zone or stuck high
+	int channel;
+
+	if(rose | fell | late | check)
+	{
+		for(channel = 0; channel < RANGER_CHANNELS; channel++)
+		{
+			alt_u32 bit = 1u << channel;
+
+			if(rose & bit)						//Echo start time
+			{
+				rise[channel] = now;
+				PROBE_ADD(PROBE_RISE, now - deadline + RANGER_RISE_TIMEOUT);
+			}
+			else if(fell & bit)					//Echo length
+			{
+				raw[channel] = (int)(now - rise[channel]);
+				alarm_echo(channel, raw[channel]);
+				result[channel] = calib_ticks(channel, raw[channel]);
+				PROBE_ADD(PROBE_ECHO, raw[channel]);
+				cadence_echo_end(now);
+				if(raw[channel] > (int)RANGER_MAX_ECHO)	//Nothing within range
+				{
+					ranger_fail(channel, RANGER_OUT_OF_RANGE);
+				}
+				else
+				{
+					error[channel] = RANGER_OK;
+				}
+			}
+			else if(late & bit)					//No echo from the sensor
+			{
+				ranger_fail(channel, RANGER_NO_ECHO);
+			}
+			else if(check & bit)
+			{
+				alarm_high(channel, (int)(now - rise[channel]));	//Target already past a zone
+				if(now >= rise[channel] + RANGER_ECHO_TIMEOUT)	//Echo pin stuck high
+				{
+					ranger_fail(channel, RANGER_ECHO_LONG);
+					cadence_echo_end(now);
+					fell |= bit;
+				}
+			}
+		}
+		waiting &= ~(rose | late);
+		high = (high | rose) & ~fell;
+
+		echo_deadline = now + RANGER_ECHO_TIMEOUT;	//Earliest zone or timeout of the echoes still in progress sets the next check
+		for(channel = 0; channel < RANGER_CHANNELS; channel++)
+		{
+			if((high >> channel) & 1)
+			{
+				int limit = alarm_release(channel);
+
+				if(limit == 0 || limit > (int)RANGER_ECHO_TIMEOUT)
+				{
+					limit = RANGER_ECHO_TIMEOUT;
+				}
+				if(rise[channel] + limit < echo_deadline)
+				{
+					echo_deadline = rise[channel] + limit;
+				}
+			}
+		}
+	}
+}
+
+//Times the echoes of every sensor in the group from the queued edges, or one read of the input register
+static void ranger_echoes(void)
+{
+#ifdef HAL_IRQ
+	edges_event event;
+
+	while(edges_pop(EDGES_ECHO, &event))
+	{
+		level = event.level;
+		ranger_edges(level, event.time);
+	}
+	ranger_edges(level, timebase_now());
+#else
+	ranger_edges((alt_u32)hal_header_read(), timebase_now());	//Read input Pins
+#endif
+
+	if(waiting)
+	{
+		state = RANGER_WAIT_RISE;
+	}
+	else if(high)
+	{
+		state = RANGER_WAIT_FALL;
+	}
+	else
+	{
+		ranger_group_done();
+	}
+}
+
+//Starts a new reading, triggering once the cadence allows it
+void ranger_start(void)
+{
+	int channel;
+
+	for(channel = 0; channel < RANGER_CHANNELS; channel++)
+	{
+		error[channel] = RANGER_NO_ECHO;	//Sensors not in any group count as not answering
+	}
+	group = 0;
+	attempt = 0;
+	firing = groups[0];
+	ranger_holdoff();
+}
+
+//Moves the reading on to the next state when its condition is met or its deadline passes
+ranger_state ranger_poll(void)
+{
+	switch(state)
+	{
+	case RANGER_HOLDOFF:
+		if(timebase_passed(deadline))				//Once the last echoes have died out
+		{
+			output_header_set(firing);				//Turn on the trigger outputs of the group
+			PROBE_ADD(PROBE_HOLDOFF, timebase_now() - holdoff_start);
+			deadline = timebase_deadline(RANGER_TRIGGER_TICKS);
+			cadence_trigger(timebase_now());
+			state = RANGER_TRIGGER;
+		}
+		break;
+
+	case RANGER_TRIGGER:
+		if(timebase_passed(deadline))				//Once the trigger has been on for just over 10us
+		{
+			output_header_clear(firing);			//Turn off the trigger outputs of the group
+			PROBE_ADD(PROBE_TRIGGER, timebase_now() - deadline + RANGER_TRIGGER_TICKS);
+			deadline = timebase_deadline(RANGER_RISE_TIMEOUT);
+			waiting = firing;
+			high = 0;
+#ifdef HAL_IRQ
+			edges_flush(EDGES_ECHO);				//Only edges after the trigger count
+			level = (alt_u32)hal_header_read();
+#endif
+			state = RANGER_WAIT_RISE;
+		}
+		break;
+
+	case RANGER_WAIT_RISE:
+	case RANGER_WAIT_FALL:
+		ranger_echoes();
+		break;
+
+	default:
+		break;
+	}
+	return state;
+}
+
+//Returns the ticks until the reading next needs to be polled, an echo edge signals the caller sooner
+alt_u64 ranger_wait(void)
+{
+	alt_u64 next = deadline;
+	alt_u64 now = timebase_now();
+
+	switch(state)
+	{
+	case RANGER_HOLDOFF:
+	case RANGER_TRIGGER:
+		break;
+
+#ifdef HAL_IRQ
+	case RANGER_WAIT_RISE:
+	case RANGER_WAIT_FALL:
+		if(!waiting || (high && echo_deadline < next))
+		{
+			next = echo_deadline;
+		}
+		break;
+#endif
+
+	default:
+		return 0;							//Polled edges are checked on every pass
+	}
+	return next > now ? next - now : 0;
+}
+
+//Returns the echo length in ticks of the nearest sensor
+int ranger_result(void)
+{
+	return result[nearest];
+}
+
+//Returns the time the echo of the nearest sensor started
+alt_u64 ranger_time(void)
+{
+	return rise[nearest];
+}
+
+//Returns the sensor that ranger_result() came from
+int ranger_channel(void)
+{
+	return nearest;
+}
+
+//Returns the reason the last reading failed, from sensor 0 when every sensor failed
+ranger_err ranger_error(void)
+{
+	return error[nearest];
+}
+
+//Returns the number of times err has happened
+alt_u32 ranger_error_count(ranger_err err)
+{
+	return errors[err];
+}
+
+//Returns the echo length in ticks of one sensor in the last sweep
+int ranger_channel_result(int channel)
+{
+	return result[channel];
+}
+
+//Returns the echo length in ticks of one sensor in the last sweep before calibration
+int ranger_channel_raw(int channel)
+{
+	return raw[channel];
+}
+
+//Returns the time the echo of one sensor started in the last sweep
+alt_u64 ranger_channel_time(int channel)
+{
+	return rise[channel];
+}
+
+//Returns the result of one sensor in the last sweep
+ranger_err ranger_channel_error(int channel)
+{
+	return error[channel];
+}
@@ -0,0 +1,106 @@
+/*
+ * 	Non-blocking ranging engine for one or more SRF05 Ultrasonic Range Finders.
+ *
+ * 	A reading is started with ranger_start() and then moved through its states by calling ranger_poll()
+ * 	as often as possible. Each call does at most one bus read and returns straight away, so the caller can
+ * 	update the display and read the inputs while the sound is in flight. ranger_wait() gives how long the
+ * 	caller can leave it between polls, so the hold off and, with edge interrupts, the echo are not spun on.
+ * 	Once ranger_poll() returns RANGER_DONE the echo length in timestamp ticks is given by ranger_result().
+ *
+ * 	Every wait has a deadline, so a missing or miswired sensor can never hang the board. A reading that
+ * 	fails is retried up to the set number of times and then ends in RANGER_ERROR, with the reason given
+ * 	by ranger_error(). The longest a reading can take is therefore a known constant:
+ * 	(retries + 1) x (hold off + RANGER_TRIGGER_TICKS + RANGER_RISE_TIMEOUT + RANGER_ECHO_TIMEOUT) per group.
+ *
+ * 	Up to RANGER_CHANNELS sensors are supported, sensor n using header output bit n as its trigger and
+ * 	header input bit n as its echo. A reading is a sweep through the groups set by ranger_pattern(), each
+ * 	group being a mask of sensors triggered together. All sensors in a group are timed by one poll loop
+ * 	that reads the input register once and finds every rising and falling edge at the same time, so a
+ * 	group costs one echo time however many sensors it has. Sensors with overlapping beams should be put in
+ * 	separate groups(staggered), sensors with separate beams in one group(simultaneous, the default).
+ * 	After a sweep ranger_result() gives the nearest sensor's echo and ranger_channel_result() each sensor's.
+ * 	Results are corrected by each sensor's calibration(calib.h) as the echo ends, ranger_channel_raw() gives
+ * 	the echo as measured. The alarm zones(alarm.h) are checked against the echo as measured, as it ends.
+ *
+ *	<States>
+ *	RANGER_IDLE			//No reading has been started
+ *	RANGER_HOLDOFF		//Trigger off, waiting until cadence.c allows the next trigger
+ *	RANGER_TRIGGER		//Trigger on, waiting RANGER_TRIGGER_TICKS(Time for signal to reach the SRF05)
+ *	RANGER_WAIT_RISE	//Trigger off, waiting for the echo pins to go high
+ *	RANGER_WAIT_FALL	//Echo pins high, waiting for them to go low
+ *	RANGER_DONE			//Echo length is ready in ranger_result()
+ *	RANGER_ERROR		//Reading failed on every sensor, the reason is given by ranger_error()
+ *	<END>>>
+ *
+ *	<Errors>
+ *	RANGER_NO_ECHO		//The echo pin did not go high after the trigger(sensor unplugged or not powered)
+ *	RANGER_ECHO_LONG	//The echo pin did not go low again(miswired or stuck input)
+ *	RANGER_OUT_OF_RANGE	//The echo ended but is longer than the SRF05's 4m range(nothing in front of it)
+ *	<END>>>
+ *
+ *	<Console Commands>
+ *	e		//Prints the retries and how many times each error has happened, retried ones included
+ *	<n>e	//Sets the retries first
+ *	0g		//Triggers every sensor together in one group(simultaneous)
+ *	1g		//Triggers each sensor in a group of its own(staggered)
+ *	<END>>>
+ */
+
+#ifndef RANGER_H_
+#define RANGER_H_
+
+#include "timebase.h"
+
+#ifndef RANGER_CHANNELS
+#define RANGER_CHANNELS			1						//Number of SRF05s connected
+#endif
+#define RANGER_ALL				((1u << RANGER_CHANNELS) - 1)	//Mask of every sensor
+
+#define RANGER_TRIGGER_TICKS	(TIMEBASE_US(10) + 1)	//Length of the trigger pulse, just over the SRF05's 10us(501 at 50MHz)
+#define RANGER_RISE_TIMEOUT		TIMEBASE_MS(5)			//Longest wait for the echo to start
+#define RANGER_ECHO_TIMEOUT		TIMEBASE_MS(40)			//Longest echo, the SRF05 gives 30ms when nothing is found
+#define RANGER_MAX_ECHO			TIMEBASE_MS(25)			//Echo length of the SRF05's 4m range with some margin
+
+#ifndef RANGER_RETRIES
+#define RANGER_RETRIES			2						//Retries after a missing or stuck echo
+#endif
+#define RANGER_MAX_RETRIES		8						//Most retries the console accepts
+
+typedef enum
+{
+	RANGER_IDLE,
+	RANGER_HOLDOFF,
+	RANGER_TRIGGER,
+	RANGER_WAIT_RISE,
+	RANGER_WAIT_FALL,
+	RANGER_DONE,
+	RANGER_ERROR
+} ranger_state;
+
+typedef enum
+{
+	RANGER_OK,
+	RANGER_NO_ECHO,
+	RANGER_ECHO_LONG,
+	RANGER_OUT_OF_RANGE,
+	RANGER_ERRORS									//Number of error codes
+} ranger_err;
+
+void ranger_init(void);						//Turns the triggers off and adds the console commands
+void ranger_retries(int retries);			//Sets how many times a failed reading is retried
+void ranger_pattern(const alt_u32 *groups, int count);	//Sets the trigger groups of a sweep, in order
+void ranger_start(void);					//Starts a new reading, abandoning any reading in progress
+ranger_state ranger_poll(void);				//Advances the reading and returns its state
+alt_u64 ranger_wait(void);					//Ticks until the reading next needs ranger_poll(), 0 to poll on every pass
+int ranger_result(void);					//Echo length in ticks of the nearest sensor
+alt_u64 ranger_time(void);					//Time the echo of the nearest sensor started
+int ranger_channel(void);					//Sensor that ranger_result() came from
+ranger_err ranger_error(void);				//Reason the last reading failed
+alt_u32 ranger_error_count(ranger_err err);	//Number of times err has happened, including retried ones
+
+int ranger_channel_result(int channel);		//Echo length in ticks of one sensor in the last sweep
+int ranger_channel_raw(int channel);		//Echo length of one sensor in the last sweep before calibration(calib.h)
+alt_u64 ranger_channel_time(int channel);	//Time the echo of one sensor started in the last sweep
+ranger_err ranger_channel_error(int channel);	//Result of one sensor in the last sweep
+
+#endif /* RANGER_H_ */
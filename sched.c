@@ -0,0 +1,89 @@
+/*
+ * 	Deadline based cooperative scheduler, see sched.h.
+ *
+ * 	Due times are on the 64-bit time base, so they never wrap.
+ */
+
+#include "sched.h"
+
+typedef struct
+{
+	sched_fn fn;						//Task function
+	alt_u64 due;						//Time the task is due at
+	int active;							//1 when the task is waiting to run
+} sched_task;
+
+static sched_task tasks[SCHED_TASKS];
+static volatile alt_u8 signalled[SCHED_TASKS];	//Set by interrupts, cleared when the task runs
+static int task_count = 0;
+
+//Adds a stopped task and returns its id, or -1 if there is no room
+int sched_add(sched_fn fn)
+{
+	if(task_count >= SCHED_TASKS)
+	{
+		return -1;
+	}
+	tasks[task_count].fn = fn;
+	tasks[task_count].active = 0;
+	return task_count++;
+}
+
+//Runs the task once delay ticks have passed
+void sched_wake(int id, alt_u64 delay)
+{
+	tasks[id].due = timebase_deadline(delay);
+	tasks[id].active = 1;
+}
+
+//Stops the task from running
+void sched_stop(int id)
+{
+	tasks[id].active = 0;
+}
+
+//Runs a waiting task on the next pass, only ever sets the flag so it is safe to call from an interrupt
+void sched_signal(int id)
+{
+	signalled[id] = 1;
+}
+
+//Runs every task that is due or signalled, in the order they were added, or idles until the first one is due
+void sched_run(void)
+{
+	alt_u64 now = timebase_now();
+	alt_u64 next = now + SCHED_IDLE_MAX;	//Earliest due time of the waiting tasks
+	int ran = 0;
+	int id;
+
+	for(id = 0; id < task_count; id++)
+	{
+		if(tasks[id].active && (signalled[id] || now >= tasks[id].due))
+		{
+			tasks[id].active = 0;		//The task wakes itself again if it needs to
+			signalled[id] = 0;			//Cleared before it runs, so a later signal runs it again
+			tasks[id].fn();
+			ran = 1;
+		}
+	}
+	if(ran)
+	{
+		return;							//Tasks may have woken others, check again
+	}
+
+	for(id = 0; id < task_count; id++)
+	{
+		if(tasks[id].active)
+		{
+			if(signalled[id])
+			{
+				return;					//Signalled since the check above
+			}
+			if(tasks[id].due < next)
+			{
+				next = tasks[id].due;
+			}
+		}
+	}
+	hal_idle(next > now ? next - now : 0);
+}
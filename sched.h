@@ -0,0 +1,29 @@
+/*
+ * 	Deadline based cooperative scheduler.
+ *
+ * 	A task is a function that runs to completion without waiting. Each task has a due time and runs once
+ * 	from sched_run() when that time has passed. A task that wants to run again calls sched_wake() on itself
+ * 	with the delay until its next run, a delay of 0 runs it again on the next pass.
+ * 	Nothing ever busy-waits, so a task that shows a value for 3 seconds does not stop the buttons being read.
+ * 	An interrupt can bring a waiting task forward with sched_signal(), so a task waiting for an edge can
+ * 	sleep until its timeout instead of checking on every pass. When no task is due sched_run() hands the
+ * 	time until the first one is to hal_idle(), at most SCHED_IDLE_MAX so the time base is still read often.
+ */
+
+#ifndef SCHED_H_
+#define SCHED_H_
+
+#include "timebase.h"
+
+#define SCHED_TASKS		8				//Maximum number of tasks
+#define SCHED_IDLE_MAX	TIMEBASE_SEC(1)	//Longest idle wait, well inside a wrap of the timestamp counter
+
+typedef void (*sched_fn)(void);
+
+int sched_add(sched_fn fn);				//Adds a stopped task and returns its id
+void sched_wake(int id, alt_u64 delay);	//Runs the task once delay ticks have passed
+void sched_stop(int id);				//Stops the task from running
+void sched_signal(int id);				//Runs a waiting task on the next pass, safe to call from an interrupt
+void sched_run(void);					//Runs every task that is due, or idles until the first one is
+
+#endif /* SCHED_H_ */
@@ -0,0 +1,72 @@
+/*
+ * 	Timed display sequences for the SSEG display, see show.h.
+ */
+
+#include "sched.h"
+#include "show.h"
+#include "output.h"
+
+typedef struct
+{
+	int word;							//Display word
+	alt_u64 ticks;						//How long the word is shown
+} show_step;
+
+static show_step steps[SHOW_STEPS];		//Queued words, oldest first
+static int head = 0;					//Next word to be shown
+static int count = 0;					//Number of queued words
+static int playing = 0;					//1 while a word is being shown
+static int task = -1;					//Scheduler task id
+
+//Shows the next word and wakes again when its time is up
+static void show_task(void)
+{
+	if(count == 0)						//Sequence finished
+	{
+		playing = 0;
+		return;
+	}
+
+	output_sseg(steps[head].word);		//Display the word on the SSEG display
+	sched_wake(task, steps[head].ticks);
+	head = (head + 1) % SHOW_STEPS;
+	count--;
+}
+
+//Adds the playback task to the scheduler
+void show_init(void)
+{
+	task = sched_add(show_task);
+}
+
+//Queues a word to be shown for ticks, starting the sequence if it is not playing
+void show_add(int word, alt_u64 ticks)
+{
+	if(count >= SHOW_STEPS)
+	{
+		return;
+	}
+	steps[(head + count) % SHOW_STEPS].word = word;
+	steps[(head + count) % SHOW_STEPS].ticks = ticks;
+	count++;
+
+	if(!playing)
+	{
+		playing = 1;
+		sched_wake(task, 0);
+	}
+}
+
+//Ends the sequence, leaving the current word on the display
+void show_stop(void)
+{
+	sched_stop(task);
+	count = 0;
+	playing = 0;
+}
+
+//Returns 1 while a sequence is playing
+int show_busy(void)
+{
+	return playing;
+}
@@ -0,0 +1,20 @@
+/*
+ * 	Timed display sequences for the SSEG display.
+ *
+ * 	A sequence is a list of display words, each shown for a set time, played back by a scheduler task.
+ * 	show_add() queues a word and returns straight away, show_stop() ends the sequence early.
+ */
+
+#ifndef SHOW_H_
+#define SHOW_H_
+
+#include "hal.h"
+
+#define SHOW_STEPS 16					//Maximum number of words in a sequence
+
+void show_init(void);					//Adds the playback task to the scheduler
+void show_add(int word, alt_u64 ticks);	//Queues a word to be shown for ticks
+void show_stop(void);					//Ends the sequence, leaving the current word on the display
+int show_busy(void);					//1 while a sequence is playing
+
+#endif /* SHOW_H_ */
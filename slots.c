@@ -0,0 +1,50 @@
+/*
+ * 	Save slots, see slots.h.
+ */
+
+#include "slots.h"
+#include "store.h"
+
+static int slots[SLOTS_UNITS][SLOTS];				//Ticks saved in each slot
+
+//Restores the slots from the store, slots that were never saved are empty
+void slots_init(void)
+{
+	alt_u32 value;
+	int unit, slot;
+
+	for(unit = 0; unit < SLOTS_UNITS; unit++)
+	{
+		for(slot = 0; slot < SLOTS; slot++)
+		{
+			slots[unit][slot] = store_get(SLOTS_KEY + unit * SLOTS + slot, &value) ? (int)value : SLOTS_EMPTY;
+		}
+	}
+}
+
+//Saves ticks to the slots in mask
+void slots_save(int mask, int unit, int ticks)
+{
+	int slot;
+
+	for(slot = 0; slot < SLOTS; slot++)
+	{
+		if((mask >> slot) & 1)
+		{
+			slots[unit][slot] = ticks;
+			store_set(SLOTS_KEY + unit * SLOTS + slot, (alt_u32)ticks);
+		}
+	}
+}
+
+//Empties the slots in mask
+void slots_clear(int mask, int unit)
+{
+	slots_save(mask, unit, SLOTS_EMPTY);
+}
+
+//Returns the ticks saved in a slot(1 to SLOTS), SLOTS_EMPTY if none
+int slots_get(int slot, int unit)
+{
+	return slots[unit][slot - 1];
+}
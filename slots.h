@@ -0,0 +1,26 @@
+/*
+ * 	Save slots.
+ *
+ * 	Five slots are kept for each display unit(CM and M), indexed by slot and unit. A slot holds the raw
+ * 	echo length in ticks, so it can be shown in whatever unit and decimal point setting is selected when it
+ * 	is loaded. Slots are kept in store.c and so survive a power cycle when the board has flash.
+ *
+ * 	Slots are selected with a mask, slot n in bit n - 1, the same order as the SV switches.
+ */
+
+#ifndef SLOTS_H_
+#define SLOTS_H_
+
+#include "hal.h"
+
+#define SLOTS			5							//Slots per unit
+#define SLOTS_UNITS		2							//CM and M
+#define SLOTS_EMPTY		-1							//Ticks of an empty slot
+#define SLOTS_KEY		0							//First store.c key, slot n of unit u uses SLOTS_KEY + u * SLOTS + n - 1
+
+void slots_init(void);								//Restores the slots from the store
+void slots_save(int mask, int unit, int ticks);		//Saves ticks to the slots in mask
+void slots_clear(int mask, int unit);				//Empties the slots in mask
+int slots_get(int slot, int unit);					//Ticks saved in a slot, SLOTS_EMPTY if none
+
+#endif /* SLOTS_H_ */
@@ -0,0 +1,88 @@
+/*
+ * 	Seven segment(SSEG) display renderer, see sseg.h.
+ */
+
+#include "sseg.h"
+
+#define SSEG_DIGITS 10000						//Number of values four displays can show
+
+const alt_u8 sseg_digits[10] =
+{
+	0xC0,		//SSEG value for 0
+	0xF9,		//SSEG value for 1
+	0xA4,		//SSEG value for 2
+	0xB0,		//SSEG value for 3
+	0x99,		//SSEG value for 4
+	0x92,		//SSEG value for 5
+	0x82,		//SSEG value for 6
+	0xF8,		//SSEG value for 7
+	0x80,		//SSEG value for 8
+	0x98		//SSEG value for 9
+};
+
+#ifdef SSEG_CACHE
+static int sseg_cache[2][SSEG_DIGITS];			//Display words for DP = 0 and DP = 1
+#endif
+
+//Divides 0 to 81919 by 10 using a multiply by 0xCCCD/2^19
+#define SSEG_DIV10(x)	(((alt_u32)(x) * 0xCCCDu) >> 19)
+
+//Returns the display word for 0 to 9999 with the decimal point on display dp_pos
+int sseg_render(int value, int dp_pos)
+{
+	alt_u32 word = 0;
+	alt_u32 rest;
+	alt_u32 tens;
+	int pos;
+
+	if(value < 0)								//Negative values are shown as 0
+	{
+		value = 0;
+	}
+	else if(value >= SSEG_DIGITS)				//Only the four right most digits are shown
+	{
+		value = value % SSEG_DIGITS;
+	}
+
+	rest = (alt_u32)value;
+	for(pos = 0; pos < 4; pos++)				//Right most digit first
+	{
+		alt_u32 glyph;
+
+		tens = SSEG_DIV10(rest);
+		glyph = sseg_digits[rest - ((tens << 3) + (tens << 1))];	//rest - tens x 10
+		if(pos == dp_pos)
+		{
+			glyph = SSEG_DP(glyph);
+		}
+		word |= glyph << (pos * 8);
+		rest = tens;
+	}
+	return (int)word;
+}
+
+//Fills the display word cache
+void sseg_init(void)
+{
+#ifdef SSEG_CACHE
+	int value;
+
+	for(value = 0; value < SSEG_DIGITS; value++)
+	{
+		sseg_cache[0][value] = sseg_render(value,3);
+		sseg_cache[1][value] = sseg_render(value,2);
+	}
+#endif
+}
+
+//This function generates the display for the SSEG(7-segment) display
+int sseg(int distance, int DP)
+{
+#ifdef SSEG_CACHE
+	if(distance >= 0 && distance < SSEG_DIGITS)
+	{
+		return sseg_cache[DP & 1][distance];
+	}
+#endif
+	return sseg_render(distance, DP ? 2 : 3);	//Decimal point on the left most display, or the next one when DP is on
+}
@@ -0,0 +1,62 @@
+/*
+ * 	Seven segment(SSEG) display renderer.
+ *
+ * 	The SSEG_BASE PIO drives four displays, one byte each with the left most display in the top byte.
+ * 	Each byte is active low: bit 0 to 6 are segments a to g and bit 7 is the decimal point.
+ *
+ * 	Digits are looked up in a glyph table and split using a multiply by the reciprocal of 10 instead of
+ * 	divisions. Every display word for 0 to 9999 with both decimal point settings is also precomputed at
+ * 	start up, so sseg() is a single table read(80KB of SDRAM). Build with SSEG_NO_CACHE to render each
+ * 	word instead where memory is short.
+ *
+ *	   a
+ *	 f   b
+ *	   g
+ *	 e   c
+ *	   d   .
+ */
+
+#ifndef SSEG_H_
+#define SSEG_H_
+
+#include "hal.h"
+
+#ifndef SSEG_NO_CACHE
+#define SSEG_CACHE						//Display words come from the cache filled by sseg_init()
+#endif
+
+//Glyphs ##########################################################
+#define SSEG_BLANK		0xFF		//All segments off
+#define SSEG_C			0xC6
+#define SSEG_E			0x86
+#define SSEG_L			0xC7
+#define SSEG_O			0xC0
+#define SSEG_S			0x92
+#define SSEG_h			0x8B
+#define SSEG_i			0xEF
+#define SSEG_n			0xAB
+#define SSEG_r			0xAF
+#define SSEG_DASH		0xBF
+
+#define SSEG_DP(glyph)	((glyph) & 0x7F)		//Adds the decimal point to a glyph
+
+//Builds a display word from four glyphs, left to right
+#define SSEG_WORD(g3,g2,g1,g0)	((int)(((alt_u32)(g3) << 24) | ((alt_u32)(g2) << 16) | ((alt_u32)(g1) << 8) | (alt_u32)(g0)))
+
+//Display words ###################################################
+#define SSEG_BLANK_WORD	SSEG_WORD(SSEG_BLANK,SSEG_BLANK,SSEG_BLANK,SSEG_BLANK)					//Blank display
+#define SSEG_ERR		SSEG_WORD(SSEG_E,SSEG_r,SSEG_DP(SSEG_r),SSEG_BLANK)						//Err.
+#define SSEG_ERR_CODE(n)	SSEG_WORD(SSEG_E,SSEG_r,SSEG_DP(SSEG_r),sseg_digits[(n)])		//Err.1 to Err.9
+#define SSEG_HI			SSEG_WORD(SSEG_h,SSEG_DP(SSEG_i),SSEG_BLANK,SSEG_BLANK)				//hi.
+#define SSEG_LO			SSEG_WORD(SSEG_L,SSEG_DP(SSEG_O),SSEG_BLANK,SSEG_BLANK)				//LO.
+#define SSEG_CE			SSEG_WORD(SSEG_C,SSEG_DP(SSEG_E),SSEG_BLANK,SSEG_BLANK)				//CE.
+#define SSEG_NCE		SSEG_WORD(SSEG_DP(SSEG_n),SSEG_C,SSEG_DP(SSEG_E),SSEG_BLANK)			//n.CE.
+#define SSEG_SV(slot)	SSEG_WORD(SSEG_DP(SSEG_S),sseg_digits[(slot)],SSEG_BLANK,SSEG_BLANK)	//S.1 to S.5
+
+extern const alt_u8 sseg_digits[10];			//Glyphs for 0 to 9
+
+void sseg_init(void);							//Fills the display word cache when SSEG_CACHE is defined
+int sseg_render(int value, int dp_pos);			//Display word for 0 to 9999 with the decimal point on display dp_pos(0 = right most, -1 = none)
+int sseg(int distance, int DP);					//Display word with the decimal point set by the DP switch
+
+#endif /* SSEG_H_ */
@@ -0,0 +1,196 @@
+/*
+ * 	Streaming statistics over the raw SRF05 readings, see stats.h.
+ *
+ * 	Readings are numbered in the order they are added. The ring buffer holds numbers first to next - 1,
+ * 	and each monotonic queue holds the numbers of the readings that can still become the window's minimum
+ * 	(or maximum), oldest first, so the answer is always at the head of the queue.
+ */
+
+#include "stats.h"
+#include "ranger.h"
+
+#define STATS_MASK (STATS_SAMPLES - 1)
+#define STATS_MAX_TICKS	((alt_u64)RANGER_ECHO_TIMEOUT * 2)	//Longest echo after calibration(calib.h), whose gain is at most 2
+
+TIMING_CHECK(squares_fit, STATS_MAX_TICKS <= 0xFFFFFFFFFFFFFFFFull / STATS_SAMPLES / STATS_MAX_TICKS);	//sum_sq of a full window of the longest echoes fits 64 bits
+
+typedef struct
+{
+	alt_u64 time;								//Time the reading was taken
+	alt_u32 ticks;								//Echo length
+} stats_sample;
+
+static stats_sample ring[STATS_SAMPLES];
+static alt_u32 first = 0;						//Number of the oldest reading in the window
+static alt_u32 next = 0;						//Number the next reading will get
+
+static alt_u32 minq[STATS_SAMPLES];				//Increasing echo lengths
+static alt_u32 min_head = 0;
+static alt_u32 min_tail = 0;
+static alt_u32 maxq[STATS_SAMPLES];				//Decreasing echo lengths
+static alt_u32 max_head = 0;
+static alt_u32 max_tail = 0;
+
+static alt_u64 sum = 0;							//Sum of the echo lengths in the window
+static alt_u64 sum_sq = 0;						//Sum of the squared echo lengths in the window
+
+static int low = 0;								//Shortest echo since the last reset
+static int high = 0;							//Longest echo since the last reset
+static int any = 0;								//1 once a reading has been added since the last reset
+
+//Removes the oldest reading from the window
+static void stats_drop(void)
+{
+	alt_u32 ticks = ring[first & STATS_MASK].ticks;
+
+	sum -= ticks;
+	sum_sq -= (alt_u64)ticks * ticks;
+	if(min_head != min_tail && minq[min_head & STATS_MASK] == first)
+	{
+		min_head++;
+	}
+	if(max_head != max_tail && maxq[max_head & STATS_MASK] == first)
+	{
+		max_head++;
+	}
+	first++;
+}
+
+//Empties the window and clears the highest and lowest readings
+void stats_reset(void)
+{
+	first = next = 0;
+	min_head = min_tail = 0;
+	max_head = max_tail = 0;
+	sum = sum_sq = 0;
+	low = high = 0;
+	any = 0;
+}
+
+//Adds a reading taken at time, dropping readings that are too old or do not fit
+void stats_add(alt_u64 time, int ticks)
+{
+	alt_u32 value = ticks > 0 ? (alt_u32)ticks : 0;
+
+	while(first != next && (next - first == STATS_SAMPLES || time - ring[first & STATS_MASK].time > STATS_WINDOW))
+	{
+		stats_drop();
+	}
+
+	while(min_head != min_tail && ring[minq[(min_tail - 1) & STATS_MASK] & STATS_MASK].ticks >= value)
+	{
+		min_tail--;								//Readings longer than this one can no longer be the minimum
+	}
+	minq[min_tail++ & STATS_MASK] = next;
+
+	while(max_head != max_tail && ring[maxq[(max_tail - 1) & STATS_MASK] & STATS_MASK].ticks <= value)
+	{
+		max_tail--;								//Readings shorter than this one can no longer be the maximum
+	}
+	maxq[max_tail++ & STATS_MASK] = next;
+
+	ring[next & STATS_MASK].time = time;
+	ring[next & STATS_MASK].ticks = value;
+	next++;
+	sum += value;
+	sum_sq += (alt_u64)value * value;
+
+	if(!any || (int)value < low)				//Highest and lowest are checked separately so neither is missed
+	{
+		low = (int)value;
+	}
+	if(!any || (int)value > high)
+	{
+		high = (int)value;
+	}
+	any = 1;
+}
+
+//Returns the number of readings in the window
+int stats_count(void)
+{
+	return (int)(next - first);
+}
+
+//Returns the shortest echo in the window, 0 if it is empty
+int stats_min(void)
+{
+	return min_head != min_tail ? (int)ring[minq[min_head & STATS_MASK] & STATS_MASK].ticks : 0;
+}
+
+//Returns the longest echo in the window, 0 if it is empty
+int stats_max(void)
+{
+	return max_head != max_tail ? (int)ring[maxq[max_head & STATS_MASK] & STATS_MASK].ticks : 0;
+}
+
+//Returns the mean echo length in the window, 0 if it is empty
+int stats_mean(void)
+{
+	alt_u32 count = next - first;
+	return count ? (int)(sum / count) : 0;
+}
+
+//Returns the variance of the echo length in the window, in ticks squared
+alt_u64 stats_variance(void)
+{
+	alt_u64 count = next - first;
+
+	if(count < 2)
+	{
+		return 0;
+	}
+	return (sum_sq - sum * (sum / count) - sum * (sum % count) / count) / count;	//sum x sum / count without forming sum x sum
+}
+
+//Returns the standard deviation of the echo length in the window, the square root of the variance rounded down
+int stats_deviation(void)
+{
+	alt_u64 rest = stats_variance();
+	alt_u64 root = 0;
+	alt_u64 bit = (alt_u64)1 << 62;					//Highest power of 4 an alt_u64 holds
+
+	while(bit > rest)
+	{
+		bit >>= 2;
+	}
+	while(bit)										//One bit of the root per step, no multiply or divide
+	{
+		if(rest >= root + bit)
+		{
+			rest -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else
+		{
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (int)root;
+}
+
+//Returns the readings per 1000 seconds over the window
+int stats_rate(void)
+{
+	alt_u64 span;
+
+	if(next - first < 2)
+	{
+		return 0;
+	}
+	span = ring[(next - 1) & STATS_MASK].time - ring[first & STATS_MASK].time;
+	return span ? (int)((alt_u64)(next - first - 1) * TIMING_HZ * 1000 / span) : 0;
+}
+
+//Returns the shortest echo since the last reset
+int stats_low(void)
+{
+	return low;
+}
+
+//Returns the longest echo since the last reset
+int stats_high(void)
+{
+	return high;
+}
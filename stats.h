@@ -0,0 +1,35 @@
+/*
+ * 	Streaming statistics over the raw SRF05 readings.
+ *
+ * 	Readings are kept as echo lengths in ticks with the time they were taken, so the results do not depend
+ * 	on the CM_M or DP settings and can be converted for whichever display mode asks for them.
+ *
+ * 	The last STATS_SAMPLES readings taken within the last STATS_WINDOW ticks are held in a ring buffer.
+ * 	Adding a reading updates the window's minimum and maximum with two monotonic queues and its mean and
+ * 	variance with running sums, so every query is O(1) and nothing is ever rescanned.
+ * 	The highest and lowest reading since the last stats_reset() are kept separately for the hi/LO display.
+ */
+
+#ifndef STATS_H_
+#define STATS_H_
+
+#include "timebase.h"
+
+#define STATS_SAMPLES	512						//Ring buffer size, must be a power of 2
+#define STATS_WINDOW	TIMEBASE_SEC(5)			//Readings older than this leave the window
+
+void stats_reset(void);							//Empties the window and clears the highest and lowest readings
+void stats_add(alt_u64 time, int ticks);		//Adds a reading taken at time
+
+int stats_count(void);							//Number of readings in the window
+int stats_min(void);							//Shortest echo in the window
+int stats_max(void);							//Longest echo in the window
+int stats_mean(void);							//Mean echo length in the window
+alt_u64 stats_variance(void);					//Variance of the echo length in the window, in ticks squared
+int stats_deviation(void);						//Standard deviation of the echo length in the window, in ticks
+int stats_rate(void);							//Readings per 1000 seconds over the window
+
+int stats_low(void);							//Shortest echo since the last reset, 0 if none
+int stats_high(void);							//Longest echo since the last reset, 0 if none
+
+#endif /* STATS_H_ */
@@ -0,0 +1,239 @@
+/*
+ * 	Persistent store of 32-bit values in flash, see store.h.
+ *
+ * 	A compaction erases the next sector and copies the records into it before writing its header, so the
+ * 	old sector stays the active one until the new one is complete. Power lost part way through only leaves
+ * 	a sector with no header, which is ignored and erased again by the next compaction.
+ *
+ * 	Every append moves on to the next record, even when the write fails, and a record with an erased key
+ * 	but other bytes programmed is skipped while restoring. So no record is ever programmed twice.
+ */
+
+#include "store.h"
+
+#define STORE_MAGIC		0x35465253				//"SRF5"
+#define STORE_CHUNK		32						//Records read at a time while restoring
+
+typedef struct
+{
+	alt_u8 key;
+	alt_u8 zero;
+	alt_u16 crc;								//CRC16 of key and value
+	alt_u32 value;
+} store_record;
+
+typedef struct
+{
+	alt_u32 magic;
+	alt_u32 generation;							//Incremented each time the log moves to the next sector
+} store_header;
+
+#define STORE_RECORDS	((HAL_FLASH_SECTOR - sizeof(store_header)) / sizeof(store_record))	//Records per sector
+
+static alt_u32 values[STORE_KEYS];				//Latest value of each key
+static alt_u32 present = 0;						//Keys that have a value, key n in bit n
+
+#ifdef HAL_FLASH
+
+static int sector = -1;							//Active sector, -1 if the flash can not be used
+static alt_u32 generation = 0;					//Generation of the active sector
+static alt_u32 next = 0;						//Next free record in the active sector
+
+//Returns the flash offset of a record
+static alt_u32 store_offset(int at_sector, alt_u32 record)
+{
+	return STORE_OFFSET + (alt_u32)at_sector * HAL_FLASH_SECTOR + sizeof(store_header) + record * sizeof(store_record);
+}
+
+//CRC16-CCITT of a record's key and value
+static alt_u16 store_crc(alt_u8 key, alt_u32 value)
+{
+	alt_u8 bytes[5];
+	alt_u16 crc = 0xFFFF;
+	int i, bit;
+
+	bytes[0] = key;
+	bytes[1] = (alt_u8)value;
+	bytes[2] = (alt_u8)(value >> 8);
+	bytes[3] = (alt_u8)(value >> 16);
+	bytes[4] = (alt_u8)(value >> 24);
+
+	for(i = 0; i < 5; i++)
+	{
+		crc ^= (alt_u16)bytes[i] << 8;
+		for(bit = 0; bit < 8; bit++)
+		{
+			crc = (crc & 0x8000) ? (alt_u16)((crc << 1) ^ 0x1021) : (alt_u16)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+//Returns 1 if every byte of a record is erased
+static int store_erased(const store_record *record)
+{
+	const alt_u8 *bytes = (const alt_u8 *)record;
+	int i;
+
+	for(i = 0; i < (int)sizeof(store_record); i++)
+	{
+		if(bytes[i] != 0xFF)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+//Appends a record to a sector, using up the record even if the write fails part way
+static int store_append(int at_sector, int key, alt_u32 value)
+{
+	store_record record;
+
+	record.key = (alt_u8)key;
+	record.zero = 0;
+	record.crc = store_crc(record.key, value);
+	record.value = value;
+	return hal_flash_write(store_offset(at_sector, next++), &record, sizeof(record));
+}
+
+//Starts the log again in the next sector, holding only the latest value of each key
+static void store_compact(void)
+{
+	store_header header;
+	int target = (sector + 1) % STORE_SECTORS;
+	alt_u32 base = STORE_OFFSET + (alt_u32)target * HAL_FLASH_SECTOR;
+	int key;
+
+	next = 0;
+	if(hal_flash_erase(base) < 0)
+	{
+		sector = -1;							//Flash not usable, keep the values in RAM only
+		return;
+	}
+	for(key = 0; key < STORE_KEYS; key++)		//Records first, the old sector is still the active one
+	{
+		if((present >> key) & 1 && store_append(target, key, values[key]) < 0)
+		{
+			sector = -1;
+			return;
+		}
+	}
+
+	header.magic = STORE_MAGIC;					//Header last makes the new sector the active one
+	header.generation = generation + 1;
+	if(hal_flash_write(base, &header, sizeof(header)) < 0)
+	{
+		sector = -1;
+		return;
+	}
+	sector = target;
+	generation++;
+}
+
+//Finds the active sector and replays its log
+void store_init(void)
+{
+	store_header header;
+	store_record records[STORE_CHUNK];
+	int count;
+	int i;
+
+	sector = -1;
+	for(i = 0; i < STORE_SECTORS; i++)			//Active sector has the highest generation
+	{
+		if(hal_flash_read(STORE_OFFSET + (alt_u32)i * HAL_FLASH_SECTOR, &header, sizeof(header)) < 0)
+		{
+			return;								//No flash, values are kept in RAM only
+		}
+		if(header.magic == STORE_MAGIC && (sector < 0 || header.generation > generation))
+		{
+			sector = i;
+			generation = header.generation;
+		}
+	}
+
+	if(sector < 0)								//Blank flash, start the log in the first sector
+	{
+		sector = STORE_SECTORS - 1;
+		generation = 0;
+		store_compact();
+		return;
+	}
+
+	for(next = 0; next < STORE_RECORDS; next += count)	//One sequential read of the log
+	{
+		count = STORE_RECORDS - next < STORE_CHUNK ? (int)(STORE_RECORDS - next) : STORE_CHUNK;
+		if(hal_flash_read(store_offset(sector, next), records, count * sizeof(store_record)) < 0)
+		{
+			break;
+		}
+		for(i = 0; i < count; i++)
+		{
+			if(store_erased(&records[i]))		//End of the log
+			{
+				next += i;
+				return;
+			}
+			if(records[i].key < STORE_KEYS && records[i].crc == store_crc(records[i].key, records[i].value))
+			{
+				values[records[i].key] = records[i].value;
+				present |= 1u << records[i].key;
+			}
+		}
+	}
+
+	next = STORE_RECORDS;						//Sector full, the next change compacts it
+}
+
+//Sets the value of key and appends it to the log
+void store_set(int key, alt_u32 value)
+{
+	if(key < 0 || key >= STORE_KEYS || (((present >> key) & 1) && values[key] == value))
+	{
+		return;									//Unchanged values are not written
+	}
+	values[key] = value;
+	present |= 1u << key;
+
+	if(sector < 0)
+	{
+		return;
+	}
+	if(next >= STORE_RECORDS)
+	{
+		store_compact();						//Also writes the new value
+		return;
+	}
+	store_append(sector, key, value);
+}
+
+#else
+
+//No flash, values are kept in RAM only
+void store_init(void)
+{
+}
+
+//Sets the value of key
+void store_set(int key, alt_u32 value)
+{
+	if(key >= 0 && key < STORE_KEYS)
+	{
+		values[key] = value;
+		present |= 1u << key;
+	}
+}
+
+#endif /* HAL_FLASH */
+
+//Copies the value of key into value, returns 0 if it has never been set
+int store_get(int key, alt_u32 *value)
+{
+	if(key < 0 || key >= STORE_KEYS || !((present >> key) & 1))
+	{
+		return 0;
+	}
+	*value = values[key];
+	return 1;
+}
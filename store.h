@@ -0,0 +1,36 @@
+/*
+ * 	Persistent store of 32-bit values in flash.
+ *
+ * 	Values are kept by key in RAM and every change is appended to a log in flash as one 8 byte record
+ * 	with a CRC, so a change never rewrites or erases what is already there. The log uses STORE_SECTORS
+ * 	sectors in turn: when the active sector is full the latest value of every key is copied into the
+ * 	next one, which is the only time a sector is erased. This spreads the erases evenly over the sectors.
+ *
+ * 	store_init() restores every value with one sequential read of the active sector, applying the records
+ * 	in the order they were written. A record with a bad CRC(power lost while it was written) is skipped.
+ *
+ * 	Without a flash device(HAL_FLASH not defined) values are only kept in RAM.
+ *
+ *	<Flash Layout>
+ *	Sector header	= STORE_MAGIC, generation		//The valid header with the highest generation is active
+ *	Record			= key, 0, CRC16, value			//An erased record(every byte 0xFF) marks the end of the log
+ *	<END>>>
+ */
+
+#ifndef STORE_H_
+#define STORE_H_
+
+#include "hal.h"
+
+#define STORE_KEYS		32						//Number of keys
+#define STORE_SECTORS	2						//Sectors used by the log
+
+#ifndef STORE_OFFSET
+#define STORE_OFFSET	0x3E0000				//Start of the log, the last two sectors of the 4MB flash
+#endif
+
+void store_init(void);							//Restores the values from flash
+int store_get(int key, alt_u32 *value);			//Copies the value of key into value, returns 0 if it has never been set
+void store_set(int key, alt_u32 value);			//Sets the value of key and appends it to the log
+
+#endif /* STORE_H_ */
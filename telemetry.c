@@ -0,0 +1,204 @@
+/*
+ * 	Binary telemetry of every reading over the JTAG UART, see telemetry.h.
+ */
+
+#include "telemetry.h"
+#include "sched.h"
+#include "console.h"
+
+#ifndef HAL_CONSOLE
+#define hal_console_space()	0						//No UART, frames stay in the ring
+#define hal_console_write(c)
+#endif
+
+static int enabled = 0;								//1 while telemetry is on
+static alt_u32 input = 0;							//Latest input word, recorded when telemetry is turned on
+static int task = -1;								//Scheduler task id
+
+static alt_u8 frame[TELEMETRY_PAYLOAD];				//Payload of the open frame
+static int frame_length = 0;						//0 when no frame is open
+static alt_u64 frame_opened = 0;					//Time the open frame got its first record
+static alt_u64 last_time = 0;						//Time of the last record in the open frame
+
+static alt_u8 ring[TELEMETRY_RING];					//Closed frames waiting for the UART
+static alt_u32 ring_head = 0;						//Next byte to write
+static alt_u32 ring_tail = 0;						//Next byte to send
+static alt_u32 sending_end = 0;						//End of the frame being sent, ring_tail between frames
+static alt_u32 dropped = 0;
+
+//Writes value as a varint, 7 bits per byte with the top bit set on all but the last
+int telemetry_varint(alt_u8 *out, alt_u64 value)
+{
+	int length = 0;
+
+	while(value >= 0x80)
+	{
+		out[length++] = (alt_u8)(value | 0x80);
+		value >>= 7;
+	}
+	out[length++] = (alt_u8)value;
+	return length;
+}
+
+//Copies a frame into the ring with its header and checksum, returns 0 if there is no room
+int telemetry_frame(alt_u8 sync, const alt_u8 *payload, int length)
+{
+	alt_u32 sum1 = (alt_u32)length;
+	alt_u32 sum2 = sum1;
+	int i;
+
+	if(TELEMETRY_RING - (ring_head - ring_tail) < (alt_u32)length + 4)
+	{
+		return 0;
+	}
+
+	ring[ring_head++ % TELEMETRY_RING] = sync;
+	ring[ring_head++ % TELEMETRY_RING] = (alt_u8)length;
+	for(i = 0; i < length; i++)
+	{
+		ring[ring_head++ % TELEMETRY_RING] = payload[i];
+		sum1 = (sum1 + payload[i]) % 255;			//Fletcher-16
+		sum2 = (sum2 + sum1) % 255;
+	}
+	ring[ring_head++ % TELEMETRY_RING] = (alt_u8)sum1;
+	ring[ring_head++ % TELEMETRY_RING] = (alt_u8)sum2;
+	sched_wake(task, 0);							//Starts sending, telemetry may never have been turned on
+	return 1;
+}
+
+//Copies the open frame into the ring, or drops it if there is no room
+static void telemetry_close(void)
+{
+	if(frame_length && !telemetry_frame(TELEMETRY_SYNC, frame, frame_length))
+	{
+		dropped++;
+	}
+	frame_length = 0;
+}
+
+//Moves what fits into the UART's transmit FIFO, noting where each frame ends as it starts to go out
+static void telemetry_send(void)
+{
+	int space;
+
+	for(space = hal_console_space(); space > 0 && ring_head != ring_tail; space--)
+	{
+		if(ring_tail == sending_end)				//First byte of a frame, the next holds its length
+		{
+			sending_end = ring_tail + ring[(ring_tail + 1) % TELEMETRY_RING] + 4;
+		}
+		hal_console_write(ring[ring_tail++ % TELEMETRY_RING]);
+	}
+}
+
+//Sends the rest of a frame the UART is part way through, waiting for the FIFO as needed
+void telemetry_finish(void)
+{
+	while(ring_tail != sending_end)
+	{
+		telemetry_send();
+	}
+}
+
+//Closes a frame that has waited long enough and moves what fits into the UART's transmit FIFO
+static void telemetry_task(void)
+{
+	sched_wake(task, TELEMETRY_PERIOD);
+
+	if(frame_length && timebase_elapsed(frame_opened) >= TELEMETRY_BATCH)
+	{
+		telemetry_close();
+	}
+	if(ring_head != ring_tail)
+	{
+		telemetry_send();
+	}
+}
+
+//Turns telemetry on or off from the console
+static void telemetry_toggle(void)
+{
+	telemetry_enable(!enabled);
+	console_put(enabled ? "telemetry on\n" : "telemetry off\n");
+	console_put_line("dropped", dropped);
+}
+
+//Adds the flush task and console command
+void telemetry_init(void)
+{
+	task = sched_add(telemetry_task);
+	console_add('t', telemetry_toggle, "telemetry on/off");
+}
+
+//Turns telemetry on or off, the open frame is sent when it is turned off
+void telemetry_enable(int on)
+{
+	if(enabled && !on)
+	{
+		telemetry_close();
+	}
+	if(!enabled && on)
+	{
+		enabled = on;
+		telemetry_add(timebase_now(), TELEMETRY_INPUT, 0, (int)input);	//Traces start with the inputs
+		sched_wake(task, 0);
+	}
+	enabled = on;
+}
+
+//Returns 1 while telemetry is on
+int telemetry_enabled(void)
+{
+	return enabled;
+}
+
+//Adds a record for one sensor result, the time is usually the start of its echo
+void telemetry_add(alt_u64 time, int channel, int error, int ticks)
+{
+	alt_u8 record[24];
+	alt_64 delta;
+	int length;
+	int i;
+
+	if(!enabled)
+	{
+		return;
+	}
+
+	if(frame_length == 0)							//New frame starts with the full time
+	{
+		frame_length = telemetry_varint(frame, time);
+		frame_opened = timebase_now();
+		last_time = time;
+	}
+
+	delta = (alt_64)(time - last_time);
+	length = telemetry_varint(record, (alt_u64)((delta << 1) ^ (delta >> 63)));	//Zigzag, records are not always in time order
+	record[length++] = (alt_u8)((channel << 4) | (error & 0x0F));
+	length += telemetry_varint(&record[length], (alt_u32)ticks);
+
+	if(frame_length + length > TELEMETRY_PAYLOAD)	//Full, start a new frame for this record
+	{
+		telemetry_close();
+		telemetry_add(time, channel, error, ticks);
+		return;
+	}
+	for(i = 0; i < length; i++)
+	{
+		frame[frame_length++] = record[i];
+	}
+	last_time = time;
+}
+
+//Records a change of the switches or buttons
+void telemetry_input(alt_u32 word)
+{
+	input = word;
+	telemetry_add(timebase_now(), TELEMETRY_INPUT, 0, (int)word);
+}
+
+//Returns the number of frames dropped because the ring was full
+alt_u32 telemetry_dropped(void)
+{
+	return dropped;
+}
@@ -0,0 +1,50 @@
+/*
+ * 	Binary telemetry of every reading over the JTAG UART.
+ *
+ * 	Each sensor result is added as a record to a frame being built in memory. A frame is closed when it is
+ * 	full or TELEMETRY_BATCH after its first record, and copied into a ring buffer. A scheduler task moves
+ * 	bytes from the ring to the UART only while the transmit FIFO has space, so adding a record never waits.
+ * 	When the ring is full a closed frame is dropped and counted instead. Other modules can send their own
+ * 	frames through the same ring with telemetry_frame(), using a different sync byte, so their bytes are
+ * 	never mixed into the middle of a telemetry frame.
+ *
+ * 	The 't' console command turns telemetry on and off. tools/telemetry_decode.c turns the stream back
+ * 	into CSV, skipping any console text mixed in with it. Console text is only ever written between frames:
+ * 	the console calls telemetry_finish() first, which sends the rest of a frame the UART is part way through.
+ *
+ * 	The stream is also the trace recorder: input records(channel TELEMETRY_INPUT) hold the packed switch
+ * 	and button word each time it changes, and when telemetry is turned on. The CSV can be replayed through
+ * 	the program by the host simulation with SIM_TRACE, see hal_host.c.
+ *
+ *	<Frame>
+ *	0xA5, length, payload, Fletcher-16 of length and payload(2 bytes)
+ *	payload = varint time of the first record, then records
+ *	record	= zigzag varint time since the previous record, channel << 4 | error, varint ticks
+ *			  or for input records, varint input word(input.h) in place of ticks
+ *	<END>>>
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include "timebase.h"
+
+#define TELEMETRY_SYNC		0xA5					//First byte of a frame
+#define TELEMETRY_PAYLOAD	240						//Largest payload
+#define TELEMETRY_RING		2048					//Ring buffer size, a power of 2
+#define TELEMETRY_BATCH		TIMEBASE_MS(50)			//Longest time a record waits in an open frame
+#define TELEMETRY_PERIOD	TIMEBASE_MS(1)			//The ring is moved to the UART every 1ms
+#define TELEMETRY_INPUT		15						//Channel of input records
+
+void telemetry_init(void);							//Adds the flush task and console command
+void telemetry_enable(int on);						//Turns telemetry on or off
+int telemetry_enabled(void);						//1 while telemetry is on
+void telemetry_add(alt_u64 time, int channel, int error, int ticks);	//Adds a record
+void telemetry_input(alt_u32 word);					//Records a change of the switches or buttons
+alt_u32 telemetry_dropped(void);					//Frames dropped because the ring was full
+void telemetry_finish(void);						//Sends the rest of a frame the UART is part way through
+
+int telemetry_frame(alt_u8 sync, const alt_u8 *payload, int length);	//Queues a frame of another kind, 0 if the ring is full
+int telemetry_varint(alt_u8 *out, alt_u64 value);	//Writes a varint, returns its length
+
+#endif /* TELEMETRY_H_ */
@@ -0,0 +1,47 @@
+/*
+ * 	Monotonic 64-bit time base, see timebase.h.
+ */
+
+#include "timebase.h"
+
+static alt_u32 last = 0;						//Counter value at the last read
+static alt_u64 wraps = 0;						//Counter wraps so far, in the top 32 bits
+
+//Starts the timestamp counter, this is the only place it is ever started
+void timebase_init(void)
+{
+	hal_timestamp_start();						//Start timer
+	last = 0;
+	wraps = 0;
+}
+
+//Returns the ticks since timebase_init()
+alt_u64 timebase_now(void)
+{
+	alt_u32 now = (alt_u32)hal_timestamp();		//Read timer
+
+	if(now < last)								//If the counter has wrapped since the last read
+	{
+		wraps += (alt_u64)1 << 32;
+	}
+	last = now;
+	return wraps | now;
+}
+
+//Returns the ticks since the supplied time
+alt_u64 timebase_elapsed(alt_u64 since)
+{
+	return timebase_now() - since;
+}
+
+//Returns the time ticks from now
+alt_u64 timebase_deadline(alt_u64 ticks)
+{
+	return timebase_now() + ticks;
+}
+
+//Returns 1 once the deadline has been reached
+int timebase_passed(alt_u64 deadline)
+{
+	return timebase_now() >= deadline;
+}
@@ -0,0 +1,27 @@
+/*
+ * 	Monotonic 64-bit time base.
+ *
+ * 	The timestamp counter is started once at power on and never restarted. Its 32-bit value wraps every
+ * 	2^32 / TIMING_HZ seconds(85 seconds at 50MHz), so timebase_now() counts the wraps to give a 64-bit tick
+ * 	count that never goes backwards. It must be called at least once per wrap, which the scheduler loop does on every pass.
+ *
+ * 	Waits are written as deadlines: set one with timebase_deadline() and test it with timebase_passed().
+ */
+
+#ifndef TIMEBASE_H_
+#define TIMEBASE_H_
+
+#include "hal.h"
+#include "timing.h"
+
+#define TIMEBASE_US(us)		TIMING_US(us)		//Microseconds to ticks, from the timing profile
+#define TIMEBASE_MS(ms)		TIMING_MS(ms)		//Milliseconds to ticks
+#define TIMEBASE_SEC(sec)	TIMING_SEC(sec)		//Seconds to ticks
+
+void timebase_init(void);						//Starts the timestamp counter
+alt_u64 timebase_now(void);						//Ticks since timebase_init()
+alt_u64 timebase_elapsed(alt_u64 since);		//Ticks since the supplied time
+alt_u64 timebase_deadline(alt_u64 ticks);		//Time ticks from now
+int timebase_passed(alt_u64 deadline);			//1 once the deadline has been reached
+
+#endif /* TIMEBASE_H_ */
@@ -0,0 +1,43 @@
+/*
+ * 	Timing profile, worked out at compile time from the clock frequencies in system.h.
+ *
+ * 	Every tick count and tick based scale in the program comes from TIMING_HZ, so a design with a different
+ * 	timestamp timer or a faster core only needs its system.h. The conversions round up, so a wait is never
+ * 	shorter than asked for at any frequency.
+ *
+ * 	TIMING_CHECK() stops the build when a frequency breaks an assumption, such as a scale factor or a
+ * 	product of ticks no longer fitting its type. Each module checks the assumptions it makes next to the
+ * 	code that makes them, the checks for the profile itself are below.
+ *
+ *	<Profile>
+ *	TIMING_HZ		//Timestamp ticks per second, TIMESTAMP_TIMER_FREQ
+ *	TIMING_CPU_HZ	//CPU clock, ALT_CPU_FREQ or TIMING_HZ when system.h does not give it
+ *	<END>>>
+ */
+
+#ifndef TIMING_H_
+#define TIMING_H_
+
+#include "hal.h"
+
+#define TIMING_HZ			((alt_u64)TIMESTAMP_TIMER_FREQ)		//Timestamp ticks per second
+
+#ifdef ALT_CPU_FREQ
+#define TIMING_CPU_HZ		((alt_u64)ALT_CPU_FREQ)				//CPU clock
+#else
+#define TIMING_CPU_HZ		TIMING_HZ
+#endif
+
+#define TIMING_US(us)		(((alt_u64)(us) * TIMING_HZ + 999999) / 1000000)	//Microseconds to ticks, rounded up
+#define TIMING_MS(ms)		(((alt_u64)(ms) * TIMING_HZ + 999) / 1000)			//Milliseconds to ticks, rounded up
+#define TIMING_SEC(sec)		((alt_u64)(sec) * TIMING_HZ)						//Seconds to ticks
+#define TIMING_TO_US(ticks)	((alt_u64)(ticks) * 1000000 / TIMING_HZ)			//Ticks to microseconds
+
+//Fails the build with a negative array size when cond is false
+#define TIMING_CHECK(name, cond)	typedef char timing_check_##name[(cond) ? 1 : -1]
+
+TIMING_CHECK(us_resolution, TIMING_HZ >= 1000000);					//A tick must be no longer than 1us to time a 10us trigger
+TIMING_CHECK(second_fits_counter, TIMING_HZ <= 0xFFFFFFFFu);		//The 32-bit counter must not wrap within a second
+TIMING_CHECK(timer_within_cpu, TIMING_HZ <= TIMING_CPU_HZ);			//The timestamp timer cannot count faster than the CPU clock
+
+#endif /* TIMING_H_ */
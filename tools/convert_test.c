@@ -0,0 +1,119 @@
+/*
+ * 	Exactness test and host benchmark of the fixed point conversion(convert.h) against the old float one.
+ *
+ * 	Every echo length from 0 to RANGER_ECHO_TIMEOUT is converted in all four display modes by convert_ticks()
+ * 	and by the float calculation distance_get() used to make, and the largest difference is reported. Both
+ * 	are also compared with the exact distance worked out in double. The old constant 0.34029 is only right
+ * 	for a 50MHz timer, so the float comparison is skipped at any other TIMESTAMP_TIMER_FREQ.
+ *
+ * 	The benchmark times both over the same echo lengths. The host has a hardware FPU and the NIOS II core
+ * 	does not, so the float path is far slower on the board than the host ratio shows.
+ *
+ * 	Build:	gcc -DHOST_SIM -O2 -I. -o convert_test tools/convert_test.c convert.c -lm
+ * 	Use:	convert_test		(exits 1 if any mode is more than one count out)
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "convert.h"
+#include "ranger.h"
+
+#define BENCH_PASSES	20					//Times the echo range is converted by each benchmark
+
+static volatile int sink;					//Keeps the benchmark results from being optimised away
+
+//The conversion distance_get() made before convert.c, with the same float types and truncation
+static int float_convert(int timer, int CM_M, int DP)
+{
+	float constant = 0;
+
+	if(DP == 1)
+	{
+		constant = 0.34029/10;
+	}
+	else
+	{
+		constant = 0.34029;
+	}
+	if(CM_M == 1)
+	{
+		constant = constant/100;
+	}
+	float dis = timer*constant;
+	return dis;
+}
+
+//Returns the time in seconds from a monotonic clock
+static double seconds(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+//Compares every echo length in one mode, returns the largest difference from the float and exact results
+static void compare(int mode, int *worst_float, int *worst_exact)
+{
+	static const int divs[4] = {1, 10, 100, 1000};
+	int ticks;
+
+	*worst_float = 0;
+	*worst_exact = 0;
+	for(ticks = 0; ticks <= (int)RANGER_ECHO_TIMEOUT; ticks++)
+	{
+		int fixed = convert_ticks(ticks, mode >> 1, mode & 1);
+		int exact = (int)floor((double)ticks * SOUND_SPEED_MM_S * 50 / (double)TIMING_HZ / divs[mode]);
+
+		if(TIMING_HZ == 50000000 && abs(fixed - float_convert(ticks, mode >> 1, mode & 1)) > *worst_float)
+		{
+			*worst_float = abs(fixed - float_convert(ticks, mode >> 1, mode & 1));
+		}
+		if(abs(fixed - exact) > *worst_exact)
+		{
+			*worst_exact = abs(fixed - exact);
+		}
+	}
+}
+
+//Times one conversion over the echo range, returns nanoseconds per conversion
+static double bench(int (*convert)(int, int, int), int mode)
+{
+	double start = seconds();
+	int pass, ticks;
+
+	for(pass = 0; pass < BENCH_PASSES; pass++)
+	{
+		for(ticks = 0; ticks <= (int)RANGER_ECHO_TIMEOUT; ticks += 7)
+		{
+			sink = convert(ticks, mode >> 1, mode & 1);
+		}
+	}
+	return (seconds() - start) * 1e9 / (BENCH_PASSES * ((double)RANGER_ECHO_TIMEOUT / 7 + 1));
+}
+
+int main(void)
+{
+	int failed = 0;
+	int mode;
+
+	printf("timer %llu Hz, echo lengths 0 to %llu ticks\n", (unsigned long long)TIMING_HZ, (unsigned long long)RANGER_ECHO_TIMEOUT);
+	printf("mode          vs float  vs exact  fixed ns  float ns\n");
+	for(mode = 0; mode < 4; mode++)
+	{
+		int worst_float, worst_exact;
+
+		compare(mode, &worst_float, &worst_exact);
+		printf("CM_M=%d DP=%d  %8d  %8d  %8.2f  %8.2f\n", mode >> 1, mode & 1, worst_float, worst_exact,
+			bench(convert_ticks, mode), bench(float_convert, mode));
+		if(worst_float > 1 || worst_exact > 1)
+		{
+			failed = 1;
+		}
+	}
+	printf("%s\n", failed ? "FAILED" : "passed");
+	return failed;
+}
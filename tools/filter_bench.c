@@ -0,0 +1,176 @@
+/*
+ * 	Cost and latency benchmark of the constant read filters(filter.h), to choose a filter and window for an
+ * 	update rate.
+ *
+ * 	For each filter setting it reports:
+ * 	ns per reading		host time of one filter_add()
+ * 	step delay			readings until the output is half way to a new distance, and that in ms at the period
+ * 	ramp lag			distance behind a target moving at 1m/s once settled
+ * 	noise				RMS error on a still target with uniform jitter
+ * 	spike				largest error left by single spurious readings
+ *
+ * 	Build:	gcc -DHOST_SIM -O2 -I. -o filter_bench tools/filter_bench.c filter.c -lm
+ * 	Use:	filter_bench [period ms] [jitter mm]	(defaults 15 and 2)
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "filter.h"
+#include "convert.h"
+
+#define BENCH_READINGS	1000000				//Readings timed per setting
+#define SETTLE			40					//Readings given to settle before measuring
+
+static volatile int sink;					//Keeps the benchmark results from being optimised away
+static double per_mm;						//Echo ticks per mm
+static alt_u64 period;						//Ticks between readings
+
+//Returns the time in seconds from a monotonic clock
+static double seconds(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+//Adds reading n of distance mm and returns the output in mm
+static double feed(int n, double mm)
+{
+	return filter_add((alt_u64)(n + 1) * period, (int)(mm * per_mm + 0.5)) / per_mm;
+}
+
+//Times filter_add() over readings of a still target with jitter, returns nanoseconds per reading
+static double bench(filter_mode mode, int window)
+{
+	static int readings[BENCH_READINGS];
+	double start;
+	int n;
+
+	srand(1);
+	for(n = 0; n < BENCH_READINGS; n++)				//Made first so rand() is not timed
+	{
+		readings[n] = (int)(1000 * per_mm) + rand() % 2000;
+	}
+	filter_init(mode, window);
+	start = seconds();
+	for(n = 0; n < BENCH_READINGS; n++)
+	{
+		sink = filter_add((alt_u64)(n + 1) * period, readings[n]);
+	}
+	return (seconds() - start) * 1e9 / BENCH_READINGS;
+}
+
+//Returns the readings after a step from 1000mm to 1500mm until the output is half way
+static int step_delay(filter_mode mode, int window)
+{
+	int n;
+
+	filter_init(mode, window);
+	for(n = 0; n < SETTLE; n++)
+	{
+		feed(n, 1000);
+	}
+	for(n = 0; n < 100; n++)
+	{
+		if(feed(SETTLE + n, 1500) >= 1250)
+		{
+			return n;
+		}
+	}
+	return -1;
+}
+
+//Returns how far behind a target moving away at 1m/s the output is once settled
+static double ramp_lag(filter_mode mode, int window)
+{
+	double mm_per_reading = (double)period / TIMING_HZ * 1000;
+	double lag = 0;
+	int n;
+
+	filter_init(mode, window);
+	for(n = 0; n < SETTLE * 2; n++)
+	{
+		double mm = 500 + n * mm_per_reading;
+		double out = feed(n, mm);
+
+		if(n >= SETTLE)
+		{
+			lag += (mm - out) / SETTLE;
+		}
+	}
+	return lag;
+}
+
+//Returns the RMS error on a still target with jitter of up to jitter mm either way
+static double noise(filter_mode mode, int window, double jitter)
+{
+	double sum = 0;
+	int n;
+
+	filter_init(mode, window);
+	srand(2);
+	for(n = 0; n < 2000; n++)
+	{
+		double out = feed(n, 1000 + jitter * (2.0 * rand() / RAND_MAX - 1));
+
+		if(n >= SETTLE)
+		{
+			sum += (out - 1000) * (out - 1000);
+		}
+	}
+	return sqrt(sum / (2000 - SETTLE));
+}
+
+//Returns the largest error left by a spurious 3000mm reading every 20 readings on a still target
+static double spike(filter_mode mode, int window)
+{
+	double worst = 0;
+	int n;
+
+	filter_init(mode, window);
+	for(n = 0; n < 400; n++)
+	{
+		double out = feed(n, n % 20 == 10 ? 3000 : 1000);
+
+		if(n >= SETTLE && fabs(out - 1000) > worst)
+		{
+			worst = fabs(out - 1000);
+		}
+	}
+	return worst;
+}
+
+//Prints one filter setting
+static void report(const char *name, filter_mode mode, int window, double jitter)
+{
+	int delay = step_delay(mode, window);
+
+	printf("%-12s %6.1f  %4d %7.1f  %7.2f  %6.2f  %7.1f\n", name, bench(mode, window), delay,
+		delay * (double)period * 1000 / TIMING_HZ, ramp_lag(mode, window), noise(mode, window, jitter), spike(mode, window));
+}
+
+int main(int argc, char **argv)
+{
+	double period_ms = argc > 1 ? atof(argv[1]) : 15;
+	double jitter = argc > 2 ? atof(argv[2]) : 2;
+	char name[16];
+	int window;
+
+	per_mm = (double)TIMING_HZ * 2 / SOUND_SPEED_MM_S;
+	period = (alt_u64)(period_ms * TIMING_HZ / 1000);
+
+	printf("period %.1f ms, jitter %.1f mm\n", period_ms, jitter);
+	printf("filter       ns/rdg  step      ms  lag mm  rms mm  spike mm\n");
+	report("none", FILTER_NONE, 1, jitter);
+	for(window = 3; window <= FILTER_MAX_WINDOW; window += 2)
+	{
+		sprintf(name, "median %d", window);
+		report(name, FILTER_MEDIAN, window, jitter);
+	}
+	report("alpha-beta", FILTER_ALPHA_BETA, 1, jitter);
+	return 0;
+}
@@ -0,0 +1,200 @@
+/*
+ * 	Decodes a sample log dump(logger.h) into CSV and reports how well it packed.
+ *
+ * 	Reads the dump from a file or stdin, puts each frame's bytes back at their offset and, once the end
+ * 	frame has given the total length, writes one line per sample in the same CSV as telemetry_decode:
+ * 	time,channel,error,ticks
+ * 	Bytes that are not part of a dump frame with a good checksum, such as console text or telemetry
+ * 	frames, are skipped.
+ *
+ * 	The summary on stderr gives the bytes per sample, the sample rate the capture sustained on the board
+ * 	and the rate this program decodes at, the decode being repeated until it has run for a second. The
+ * 	board's timestamp frequency, needed for the sample rate, is taken from the end frame.
+ *
+ * 	Build:	gcc -O2 -o log_decode tools/log_decode.c
+ * 	Use:	log_decode dump.bin > readings.csv
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SYNC		0x5A
+#define END_SYNC	0x5B
+#define MAX_FRAME	(2 + 255 + 2)
+#define CHANNELS	16
+
+//Reads a varint, returns the number of bytes used or 0 if it runs past the end
+static int read_varint(const unsigned char *in, long length, unsigned long long *value)
+{
+	int used = 0;
+	int shift = 0;
+
+	*value = 0;
+	while(used < length && shift < 64)
+	{
+		*value |= (unsigned long long)(in[used] & 0x7F) << shift;
+		if(!(in[used++] & 0x80))
+		{
+			return used;
+		}
+		shift += 7;
+	}
+	return 0;
+}
+
+//Undoes the zigzag encoding
+static long long unzigzag(unsigned long long value)
+{
+	return (long long)(value >> 1) ^ -(long long)(value & 1);
+}
+
+//Decodes the log, printing each sample to out if it is not NULL, returns the number of samples
+static long decode_log(const unsigned char *log, long length, FILE *out,
+	unsigned long long *first, unsigned long long *last)
+{
+	unsigned long long time = 0, value;
+	long long ticks[CHANNELS] = {0};
+	long samples = 0;
+	long pos = 0;
+	int used;
+
+	while(pos < length)
+	{
+		int channel, error;
+
+		if(!(used = read_varint(log + pos, length - pos, &value)) || pos + used >= length)
+		{
+			break;
+		}
+		pos += used;
+		time += unzigzag(value);
+		channel = log[pos] >> 4;
+		error = log[pos] & 0x0F;
+		pos++;
+		if(!(used = read_varint(log + pos, length - pos, &value)))
+		{
+			break;
+		}
+		pos += used;
+		ticks[channel] += unzigzag(value);
+		if(samples++ == 0)
+		{
+			*first = time;
+		}
+		*last = time;
+		if(out)
+		{
+			fprintf(out, "%llu,%d,%d,%lld\n", time, channel, error, ticks[channel]);
+		}
+	}
+	return samples;
+}
+
+int main(int argc, char **argv)
+{
+	FILE *in = stdin;
+	unsigned char frame[MAX_FRAME];
+	unsigned char *log = NULL;
+	long size = 0, total = -1, received = 0;
+	unsigned long frames = 0, bad = 0;
+	unsigned long long first = 0, last = 0;
+	unsigned long long ticks_hz = 0;		//Timestamp frequency of the board, from the end frame
+	long samples, runs;
+	clock_t start;
+	double seconds;
+	int c;
+
+	if(argc > 1 && !(in = fopen(argv[1], "rb")))
+	{
+		perror(argv[1]);
+		return 1;
+	}
+
+	while((c = fgetc(in)) != EOF)
+	{
+		unsigned long long offset;
+		unsigned int sum1, sum2;
+		int length, used, i;
+
+		if(c != SYNC && c != END_SYNC)
+		{
+			continue;
+		}
+		if((length = fgetc(in)) == EOF)
+		{
+			break;
+		}
+		frame[0] = (unsigned char)length;
+		if(fread(frame + 1, 1, length + 2, in) != (size_t)length + 2)
+		{
+			break;
+		}
+
+		sum1 = sum2 = 0;
+		for(i = 0; i <= length; i++)
+		{
+			sum1 = (sum1 + frame[i]) % 255;
+			sum2 = (sum2 + sum1) % 255;
+		}
+		if(frame[length + 1] != sum1 || frame[length + 2] != sum2 || !(used = read_varint(frame + 1, length, &offset)))
+		{
+			bad++;
+			fseek(in, -(long)(length + 2), SEEK_CUR);	//Look for the next sync after this one
+			continue;
+		}
+		frames++;
+		if(c == END_SYNC)
+		{
+			total = (long)offset;
+			read_varint(frame + 1 + used, length - used, &ticks_hz);
+			continue;
+		}
+		if((long)offset + length - used > size)
+		{
+			size = ((long)offset + length - used) * 2;
+			log = realloc(log, size);
+		}
+		memcpy(log + offset, frame + 1 + used, length - used);
+		received += length - used;
+	}
+
+	if(total < 0)
+	{
+		fprintf(stderr, "%lu frames, %lu bad, no end frame\n", frames, bad);
+		return 1;
+	}
+	if(received != total)
+	{
+		fprintf(stderr, "%ld of %ld bytes received\n", received, total);
+		return 1;
+	}
+
+	printf("time,channel,error,ticks\n");
+	samples = decode_log(log, total, stdout, &first, &last);
+
+	start = clock();
+	runs = 0;
+	do
+	{
+		decode_log(log, total, NULL, &first, &last);
+		runs++;
+		seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+	} while(seconds < 1.0 && samples);
+
+	fprintf(stderr, "%lu frames, %lu bad\n", frames, bad);
+	fprintf(stderr, "%ld samples in %ld bytes, %.2f bytes per sample (13 unpacked)\n",
+		samples, total, samples ? (double)total / samples : 0.0);
+	if(last > first && ticks_hz)
+	{
+		fprintf(stderr, "capture %.3f s at %llu Hz, %.1f samples/s sustained\n",
+			(double)(last - first) / ticks_hz, ticks_hz, (samples - 1) * (double)ticks_hz / (last - first));
+	}
+	if(samples && seconds > 0)
+	{
+		fprintf(stderr, "decode %.1f million samples/s\n", samples * runs / seconds / 1e6);
+	}
+	free(log);
+	return 0;
+}
@@ -0,0 +1,165 @@
+/*
+ * 	Microbenchmark of the SSEG renderer(sseg.h) against the dig() and sseg() Program.c used to have.
+ *
+ * 	Every value from 0 to 9999 is rendered with both decimal point settings by both, and the display words
+ * 	must match exactly, as must the letter words that were magic numbers(Err, hi, LO, SV1). Both are then
+ * 	timed over the same values. Build it as is to time the precomputed cache the firmware uses, and with
+ * 	SSEG_NO_CACHE to time the table renderer. On the host the compiler turns the old code's divisions by 10
+ * 	into multiplies, as it can not on the DE0's NIOS II core with no divider, so the host timing of the old
+ * 	renderer is flattering.
+ *
+ * 	Build:	gcc -DHOST_SIM -O2 -I. -o sseg_bench tools/sseg_bench.c sseg.c
+ * 	or:		gcc -DHOST_SIM -DSSEG_NO_CACHE -O2 -I. -o sseg_bench tools/sseg_bench.c sseg.c
+ * 	Use:	sseg_bench		(exits 1 if any display word differs)
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "sseg.h"
+
+#define BENCH_PASSES	200					//Times the 0 to 9999 range is rendered by each benchmark
+
+static volatile int sink;					//Keeps the benchmark results from being optimised away
+
+//Returns the hexidecimal value of supplied number for SSEG display, as Program.c had it
+static int old_dig(int counter)
+{
+	int digit;
+
+	if(counter == 0)
+	{
+		digit = 0xC0;
+	}
+	else if(counter == 1)
+	{
+		digit = 0xF9;
+	}
+	else if(counter == 2)
+	{
+		digit = 0xA4;
+	}
+	else if(counter == 3)
+	{
+		digit = 0xB0;
+	}
+	else if(counter == 4)
+	{
+		digit = 0x99;
+	}
+	else if(counter == 5)
+	{
+		digit = 0x92;
+	}
+	else if(counter == 6)
+	{
+		digit = 0x82;
+	}
+	else if(counter == 7)
+	{
+		digit = 0xF8;
+	}
+	else if(counter == 8)
+	{
+		digit = 0x80;
+	}
+	else if(counter == 9)
+	{
+		digit = 0x98;
+	}
+	else
+	{
+		digit = 0xC0;
+	}
+	return digit;
+}
+
+//Generates the display for the SSEG display, as Program.c had it
+static int old_sseg(int distance, int DP)
+{
+	int seg1 = old_dig(distance % 10);
+	int seg2 = old_dig((distance / 10) % 10);
+	int seg3 = old_dig((distance / 100) % 10);
+	int seg4 = old_dig((distance / 1000) % 10);
+	int word;
+
+	if(DP == 0)
+	{
+		word = seg4 - 128;
+		word = word << 8;
+		word = word + seg3;
+	}
+	else
+	{
+		word = seg4;
+		word = word << 8;
+		seg3 = seg3 - 128;
+		word = word + seg3;
+	}
+	word = word << 8;
+	word = word + seg2;
+	word = word << 8;
+	word = word + seg1;
+	return word;
+}
+
+//Returns the time in seconds from a monotonic clock
+static double seconds(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+//Times one renderer over 0 to 9999 with both decimal point settings, returns nanoseconds per display word
+static double bench(int (*render)(int, int))
+{
+	double start = seconds();
+	int pass, value;
+
+	for(pass = 0; pass < BENCH_PASSES; pass++)
+	{
+		for(value = 0; value < 10000; value++)
+		{
+			sink = render(value, pass & 1);
+		}
+	}
+	return (seconds() - start) * 1e9 / (BENCH_PASSES * 10000.0);
+}
+
+int main(void)
+{
+	int differ = 0;
+	int value, dp;
+
+	sseg_init();
+	for(dp = 0; dp < 2; dp++)
+	{
+		for(value = 0; value < 10000; value++)
+		{
+			if(sseg(value, dp) != old_sseg(value, dp))
+			{
+				if(!differ)
+				{
+					printf("%d DP=%d: %08x, was %08x\n", value, dp, (unsigned int)sseg(value, dp), (unsigned int)old_sseg(value, dp));
+				}
+				differ++;
+			}
+		}
+	}
+	if(SSEG_ERR != (int)0x86AF2FFF || SSEG_HI != (int)0x8B6FFFFF || SSEG_LO != (int)0xC740FFFF || SSEG_SV(1) != (int)0x12F9FFFF)
+	{
+		printf("letter words differ from the old magic numbers\n");
+		differ++;
+	}
+#ifdef SSEG_CACHE
+	printf("renderer          display word cache\n");
+#else
+	printf("renderer          glyph table and reciprocal multiply\n");
+#endif
+	printf("differences       %d of 20000\n", differ);
+	printf("new sseg          %.2f ns\n", bench(sseg));
+	printf("old sseg          %.2f ns\n", bench(old_sseg));
+	return differ ? 1 : 0;
+}
@@ -0,0 +1,174 @@
+/*
+ * 	Host test of the streaming statistics(stats.h) against a brute force window.
+ *
+ * 	Random echo lengths are added at random gaps, in turns fast enough to fill the ring before STATS_WINDOW
+ * 	drops anything and slow enough for readings to age out, with now and then a gap that empties it. After every reading the window is worked out again by
+ * 	scanning every reading kept, and each query must give exactly what the scan gives. The scan keeps the
+ * 	same integer rounding as stats.c, so any difference is a bug, not a rounding error.
+ *
+ * 	Build:	gcc -DHOST_SIM -O2 -I. -o stats_test tools/stats_test.c stats.c -lm
+ * 	Use:	stats_test [readings]		(default 200000, exits 1 if any query differs)
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "stats.h"
+#include "ranger.h"
+
+typedef struct
+{
+	alt_u64 time;
+	int ticks;
+} reading;
+
+static reading *readings;					//Every reading added since the last reset
+static int added = 0;
+static int low = 0;							//Shortest and longest reading since the last reset
+static int high = 0;
+static int failures = 0;
+
+//Counts and prints a query that differs from the scan
+static void expect(int n, const char *name, unsigned long long got, unsigned long long want)
+{
+	if(got != want && failures++ < 10)
+	{
+		printf("reading %d: %s %llu, scan gives %llu\n", n, name, got, want);
+	}
+}
+
+//Returns the square root of value rounded down
+static alt_u64 root(alt_u64 value)
+{
+	alt_u64 r = (alt_u64)sqrtl((long double)value);
+
+	while(r * r > value)
+	{
+		r--;
+	}
+	while((r + 1) * (r + 1) <= value)
+	{
+		r++;
+	}
+	return r;
+}
+
+//Returns a random gap between readings, under 2ms when fast so the ring fills well inside STATS_WINDOW
+static alt_u64 gap(int fast)
+{
+	if(fast)
+	{
+		return rand() % 16 ? TIMING_US(rand() % 2000) : 0;	//Now and then two readings at the same time
+	}
+	switch(rand() % 8)
+	{
+	case 0:
+		return TIMING_MS(500 + rand() % 3000);
+	case 1:
+		return rand() % 50 ? TIMING_MS(rand() % 100) : TIMING_SEC(6);	//Now and then a gap that empties the window
+	default:
+		return TIMING_MS(5 + rand() % 60);
+	}
+}
+
+//Returns a random echo length, from nothing to the longest echo after calibration
+static int echo(void)
+{
+	switch(rand() % 10)
+	{
+	case 0:
+		return 0;
+	case 1:
+		return (int)(RANGER_ECHO_TIMEOUT * 2) - rand() % 100;
+	default:
+		return 50000 + rand() % 200000;
+	}
+}
+
+//Checks every query against a scan of the readings still in the window
+static void check(int n)
+{
+	alt_u64 now = readings[added - 1].time;
+	unsigned long long sum = 0;
+	unsigned __int128 sum_sq = 0;
+	alt_u64 variance = 0;
+	int first = added;
+	int min = 0, max = 0;
+	int rate = 0;
+	int count, i;
+
+	while(first > 0 && added - first < STATS_SAMPLES && now - readings[first - 1].time <= STATS_WINDOW)
+	{
+		first--;
+	}
+	count = added - first;
+	for(i = first; i < added; i++)
+	{
+		if(i == first || readings[i].ticks < min)
+		{
+			min = readings[i].ticks;
+		}
+		if(i == first || readings[i].ticks > max)
+		{
+			max = readings[i].ticks;
+		}
+		sum += (unsigned)readings[i].ticks;
+		sum_sq += (unsigned __int128)readings[i].ticks * (unsigned)readings[i].ticks;
+	}
+	if(count >= 2)
+	{
+		variance = (alt_u64)((sum_sq - (unsigned __int128)sum * sum / count) / count);
+		if(now != readings[first].time)
+		{
+			rate = (int)((alt_u64)(count - 1) * TIMING_HZ * 1000 / (now - readings[first].time));
+		}
+	}
+
+	expect(n, "count", stats_count(), count);
+	expect(n, "min", stats_min(), min);
+	expect(n, "max", stats_max(), max);
+	expect(n, "mean", stats_mean(), count ? sum / count : 0);
+	expect(n, "variance", stats_variance(), variance);
+	expect(n, "deviation", stats_deviation(), root(variance));
+	expect(n, "rate", stats_rate(), rate);
+	expect(n, "low", stats_low(), low);
+	expect(n, "high", stats_high(), high);
+}
+
+int main(int argc, char **argv)
+{
+	int total = argc > 1 ? atoi(argv[1]) : 200000;
+	alt_u64 time = TIMING_SEC(1);
+	int n;
+
+	readings = malloc(sizeof(reading) * total);
+	srand(1);
+	stats_reset();
+	for(n = 0; n < total; n++)
+	{
+		if(rand() % 20000 == 0)					//Now and then start again, as button 2 does
+		{
+			stats_reset();
+			added = 0;
+		}
+		time += gap((n / 3000) & 1);				//Fast and normal rates in turn
+		readings[added].time = time;
+		readings[added].ticks = echo();
+		stats_add(time, readings[added].ticks);
+		if(added == 0 || readings[added].ticks < low)
+		{
+			low = readings[added].ticks;
+		}
+		if(added == 0 || readings[added].ticks > high)
+		{
+			high = readings[added].ticks;
+		}
+		added++;
+		check(n);
+	}
+	printf("%d readings, %d differences\n", total, failures);
+	printf("%s\n", failures ? "FAILED" : "passed");
+	free(readings);
+	return failures ? 1 : 0;
+}
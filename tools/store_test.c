@@ -0,0 +1,259 @@
+/*
+ * 	Host test of the flash store(store.h) losing power part way through a write.
+ *
+ * 	The flash is modelled in memory shared between processes, and each boot of the board is a child process
+ * 	that starts with store_init(), so nothing is carried over in RAM. A boot that changes a value is cut off
+ * 	after 0, 1, 2... bytes have been programmed(an erase counts as one), until one finishes without a cut.
+ * 	After each cut the next boot must find every value as it was, or the changed one as it was set, and
+ * 	a value set then must still be there on the boot after. Programming a byte that is not erased counts
+ * 	as a failure, as the flash can not be trusted to hold it. An erase is taken to be all or nothing.
+ *
+ * 	Two changes are cut: an append to a sector with room, and one that fills the sector and so compacts
+ * 	every key into the other sector.
+ *
+ * 	Build:	gcc -DHOST_SIM -O2 -I. -o store_test tools/store_test.c store.c
+ * 	Use:	store_test		(exits 1 if any cut loses a value)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "store.h"
+
+#define FLASH_SIZE		(STORE_OFFSET + STORE_SECTORS * HAL_FLASH_SECTOR)
+#define RECORDS			((HAL_FLASH_SECTOR - 8) / 8)	//Records per sector, as store.c
+#define KEYS			14							//Keys set before the cuts
+#define CHANGED			3							//Key changed by the write that is cut
+
+#define BOOT_OK			0							//Exit codes of a boot
+#define BOOT_CUT		2
+#define BOOT_LOST		3
+#define BOOT_REPROGRAM	4
+
+static alt_u8 *flash;							//Flash shared with every boot
+static alt_u8 *saved;							//Flash before the write that is cut
+static long budget = -1;						//Bytes left to program before the power is cut, -1 for no cut
+static int reprogrammed = 0;					//Set when a byte that is not erased is programmed
+
+static alt_u32 want[STORE_KEYS];				//Value each key must have
+static alt_u32 changed_to = 0;					//Value the cut write sets CHANGED to
+static alt_u32 recovered = 0;					//Value CHANGED is set to on the boot after a cut
+static int failures = 0;
+
+//Cuts the power if the budget has run out
+static void flash_step(void)
+{
+	if(budget == 0)
+	{
+		_exit(BOOT_CUT);
+	}
+	if(budget > 0)
+	{
+		budget--;
+	}
+}
+
+int hal_flash_read(alt_u32 offset, void *dest, int length)
+{
+	if(offset + length > FLASH_SIZE)
+	{
+		return -1;
+	}
+	memcpy(dest, flash + offset, length);
+	return 0;
+}
+
+int hal_flash_write(alt_u32 offset, const void *src, int length)
+{
+	const alt_u8 *data = src;
+	int i;
+
+	if(offset + length > FLASH_SIZE)
+	{
+		return -1;
+	}
+	for(i = 0; i < length; i++)
+	{
+		flash_step();
+		if(flash[offset + i] != 0xFF)
+		{
+			reprogrammed = 1;
+		}
+		flash[offset + i] &= data[i];			//Programming can only clear bits
+	}
+	return 0;
+}
+
+int hal_flash_erase(alt_u32 offset)
+{
+	offset &= ~(alt_u32)(HAL_FLASH_SECTOR - 1);
+	if(offset >= FLASH_SIZE)
+	{
+		return -1;
+	}
+	flash_step();
+	memset(flash + offset, 0xFF, HAL_FLASH_SECTOR);
+	return 0;
+}
+
+//Sets the first keys
+static void work_fill(void)
+{
+	int key;
+
+	for(key = 0; key < KEYS; key++)
+	{
+		store_set(key, want[key]);
+	}
+}
+
+//Changes key 0 until the active sector is full
+static void work_full(void)
+{
+	int i;
+
+	for(i = KEYS; i < (int)RECORDS; i++)
+	{
+		store_set(0, 1000 + (i & 1));
+	}
+}
+
+//Makes the change that is cut
+static void work_change(void)
+{
+	store_set(CHANGED, changed_to);
+}
+
+//Checks every key against want, with CHANGED allowed to be changed_to as well
+static void work_check(void)
+{
+	alt_u32 value;
+	int key;
+
+	for(key = 0; key < STORE_KEYS; key++)
+	{
+		int set = key < KEYS;
+		int found = store_get(key, &value);
+
+		if(found != set || (set && value != want[key] && !(key == CHANGED && value == changed_to)))
+		{
+			printf("key %d %s\n", key, found ? "has the wrong value" : "lost");
+			fflush(stdout);
+			_exit(BOOT_LOST);
+		}
+	}
+}
+
+//Checks the values after a cut and sets CHANGED again
+static void work_recover(void)
+{
+	work_check();
+	store_set(CHANGED, recovered);
+}
+
+//Checks that the value set after the cut was kept
+static void work_recovered(void)
+{
+	alt_u32 value;
+
+	if(!store_get(CHANGED, &value) || value != recovered)
+	{
+		printf("key %d not kept after the cut\n", CHANGED);
+		fflush(stdout);
+		_exit(BOOT_LOST);
+	}
+}
+
+//Runs one boot of the board that does work, cut after cut bytes, and returns how it ended
+static int boot(long cut, void (*work)(void))
+{
+	int status;
+	pid_t pid = fork();
+
+	if(pid == 0)
+	{
+		budget = cut;
+		store_init();
+		work();
+		_exit(reprogrammed ? BOOT_REPROGRAM : BOOT_OK);
+	}
+	waitpid(pid, &status, 0);
+	return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+//Cuts the change at every byte from the saved flash and checks the boots after
+static void cut_all(const char *name)
+{
+	long cut;
+	int lost = 0;
+	int ended;
+
+	for(cut = 0; ; cut++)
+	{
+		memcpy(flash, saved, FLASH_SIZE);
+		ended = boot(cut, work_change);
+		if(ended != BOOT_OK && ended != BOOT_CUT)
+		{
+			printf("%s, cut at %ld: the change programmed flash that was not erased\n", name, cut);
+			lost++;
+		}
+		recovered = 0xC0DE0000 + (alt_u32)cut;
+		if(boot(-1, work_recover) != BOOT_OK || boot(-1, work_recovered) != BOOT_OK)
+		{
+			printf("%s, cut at %ld: value lost after the cut\n", name, cut);
+			lost++;
+		}
+		if(ended == BOOT_OK)
+		{
+			break;								//Change finished before the cut
+		}
+	}
+	printf("%-12s %4ld cut points, %d failed\n", name, cut, lost);
+	failures += lost;
+}
+
+int main(void)
+{
+	int key;
+
+	flash = mmap(NULL, FLASH_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	saved = malloc(FLASH_SIZE);
+	if(flash == MAP_FAILED || !saved)
+	{
+		printf("no memory for the flash\n");
+		return 1;
+	}
+	memset(flash, 0xFF, FLASH_SIZE);
+	for(key = 0; key < KEYS; key++)
+	{
+		want[key] = key;
+	}
+	changed_to = 0xFACE;
+
+	if(boot(-1, work_fill) != BOOT_OK || boot(-1, work_check) != BOOT_OK)
+	{
+		printf("values not kept without a cut\n");
+		return 1;
+	}
+	memcpy(saved, flash, FLASH_SIZE);
+	cut_all("append");
+
+	memcpy(flash, saved, FLASH_SIZE);
+	want[0] = 1000 + ((RECORDS - 1) & 1);
+	if(boot(-1, work_full) != BOOT_OK || boot(-1, work_check) != BOOT_OK)
+	{
+		printf("values not kept filling the sector\n");
+		return 1;
+	}
+	memcpy(saved, flash, FLASH_SIZE);
+	cut_all("compaction");
+
+	printf("%s\n", failures ? "FAILED" : "passed");
+	munmap(flash, FLASH_SIZE);
+	free(saved);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * 	Decodes the binary telemetry stream(telemetry.h) into CSV.
+ *
+ * 	Reads the stream from a file or stdin and writes one line per record:
+ * 	time,channel,error,ticks
+ * 	Bytes that are not part of a frame with a good checksum, such as console text, are skipped.
+ *
+ * 	Build:	gcc -O2 -o telemetry_decode tools/telemetry_decode.c
+ * 	Use:	telemetry_decode telemetry.bin > readings.csv
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SYNC		0xA5
+#define MAX_FRAME	(2 + 255 + 2)
+
+//Reads a varint, returns the number of bytes used or 0 if it runs past the end
+static int read_varint(const unsigned char *in, int length, unsigned long long *value)
+{
+	int used = 0;
+	int shift = 0;
+
+	*value = 0;
+	while(used < length && shift < 64)
+	{
+		*value |= (unsigned long long)(in[used] & 0x7F) << shift;
+		if(!(in[used++] & 0x80))
+		{
+			return used;
+		}
+		shift += 7;
+	}
+	return 0;
+}
+
+//Prints the records of one frame payload, returns 0 if it is malformed
+static int decode_payload(const unsigned char *payload, int length)
+{
+	unsigned long long time, delta, ticks;
+	int pos, used;
+
+	used = read_varint(payload, length, &time);
+	if(!used)
+	{
+		return 0;
+	}
+	for(pos = used; pos < length; )
+	{
+		used = read_varint(payload + pos, length - pos, &delta);
+		if(!used || pos + used >= length)
+		{
+			return 0;
+		}
+		pos += used;
+		time += (delta >> 1) ^ (0 - (delta & 1));	//Undo the zigzag
+		{
+			int channel = payload[pos] >> 4;
+			int error = payload[pos] & 0x0F;
+
+			pos++;
+			used = read_varint(payload + pos, length - pos, &ticks);
+			if(!used)
+			{
+				return 0;
+			}
+			pos += used;
+			printf("%llu,%d,%d,%llu\n", time, channel, error, ticks);
+		}
+	}
+	return 1;
+}
+
+int main(int argc, char **argv)
+{
+	FILE *in = stdin;
+	unsigned char frame[MAX_FRAME];
+	unsigned long frames = 0, bad = 0;
+	int c;
+
+	if(argc > 1 && !(in = fopen(argv[1], "rb")))
+	{
+		perror(argv[1]);
+		return 1;
+	}
+
+	printf("time,channel,error,ticks\n");
+	while((c = fgetc(in)) != EOF)
+	{
+		unsigned int sum1, sum2;
+		int length, i;
+
+		if(c != SYNC)
+		{
+			continue;
+		}
+		if((length = fgetc(in)) == EOF)
+		{
+			break;
+		}
+		frame[0] = (unsigned char)length;
+		if(fread(frame + 1, 1, length + 2, in) != (size_t)length + 2)
+		{
+			break;
+		}
+
+		sum1 = sum2 = 0;
+		for(i = 0; i <= length; i++)
+		{
+			sum1 = (sum1 + frame[i]) % 255;
+			sum2 = (sum2 + sum1) % 255;
+		}
+		if(frame[length + 1] != sum1 || frame[length + 2] != sum2 || !decode_payload(frame + 1, length))
+		{
+			bad++;
+			fseek(in, -(long)(length + 2), SEEK_CUR);	//Look for the next sync after this one
+			continue;
+		}
+		frames++;
+	}
+	fprintf(stderr, "%lu frames, %lu bad\n", frames, bad);
+	return 0;
+}
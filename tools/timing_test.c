@@ -0,0 +1,154 @@
+/*
+ * 	Host test of the timing profile(timing.h) at the timer frequency it is built with.
+ *
+ * 	Checks that the tick constants keep their real time lengths, that the Q32 conversion stays within one
+ * 	count of the exact distance over the whole echo range, and that the statistics and alpha-beta filter
+ * 	give the right answer with the longest echoes, where their 64-bit sums are closest to overflowing.
+ * 	A frequency that breaks a static check(TIMING_CHECK) fails to build instead.
+ *
+ * 	Build and run at several frequencies from the repository root:
+ * 	for f in 20000000 50000000 100000000 1000000000; do
+ * 		gcc -DHOST_SIM -DTIMESTAMP_TIMER_FREQ=$f -O2 -I. -o timing_test tools/timing_test.c convert.c stats.c filter.c -lm &&
+ * 		./timing_test || break
+ * 	done
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "timing.h"
+#include "ranger.h"
+#include "convert.h"
+#include "stats.h"
+#include "filter.h"
+
+static int failures = 0;
+
+//Prints a check and counts it if it failed
+static void check(const char *name, int ok)
+{
+	printf("%-40s %s\n", name, ok ? "ok" : "FAILED");
+	if(!ok)
+	{
+		failures++;
+	}
+}
+
+//Returns 1 if ticks is the length of seconds rounded up to a whole tick
+static int rounded_up(alt_u64 ticks, double seconds)
+{
+	double exact = seconds * (double)TIMING_HZ;
+	return ticks >= exact - 1e-6 && ticks < exact + 1;
+}
+
+//Checks the tick constants against their lengths in real time
+static void check_constants(void)
+{
+	check("TIMING_US(10) is 10us", rounded_up(TIMING_US(10), 10e-6));
+	check("TIMING_MS(50) is 50ms", rounded_up(TIMING_MS(50), 50e-3));
+	check("TIMING_SEC(5) is 5s", TIMING_SEC(5) == 5 * TIMING_HZ);
+	check("trigger pulse is over 10us", RANGER_TRIGGER_TICKS > 10e-6 * TIMING_HZ);
+	check("trigger pulse is under 11us", RANGER_TRIGGER_TICKS < 11e-6 * TIMING_HZ);
+	check("echo timeout is 40ms", rounded_up(RANGER_ECHO_TIMEOUT, 40e-3));
+	check("TIMING_TO_US inverts TIMING_US", TIMING_TO_US(TIMING_US(12345)) >= 12345 && TIMING_TO_US(TIMING_US(12345)) <= 12346);
+}
+
+//Checks every display mode against the exact distance over the echo range
+static void check_convert(void)
+{
+	static const int divs[4] = {1, 10, 100, 1000};
+	alt_u64 step = RANGER_ECHO_TIMEOUT / 200000 + 1;	//About 200000 echo lengths per mode
+	int worst = 0;
+	int limits = 1;
+	int mode;
+	alt_u64 ticks;
+	int value;
+
+	for(mode = 0; mode < 4; mode++)
+	{
+		for(ticks = 0; ticks <= RANGER_ECHO_TIMEOUT; ticks += step)
+		{
+			double exact = (double)ticks * SOUND_SPEED_MM_S * 50 / (double)TIMING_HZ / divs[mode];
+			int diff = convert_ticks((int)ticks, mode >> 1, mode & 1) - (int)floor(exact);
+
+			if(abs(diff) > worst)
+			{
+				worst = abs(diff);
+			}
+		}
+		for(value = 1; value < 10000; value += 7)
+		{
+			int limit = convert_limit(value, mode >> 1, mode & 1);
+
+			if(convert_ticks(limit, mode >> 1, mode & 1) < value || (limit > 0 && convert_ticks(limit - 1, mode >> 1, mode & 1) >= value))
+			{
+				limits = 0;
+			}
+		}
+	}
+	printf("convert worst difference                 %d count\n", worst);
+	check("convert within 1 count of exact", worst <= 1);
+	check("convert_limit is the shortest echo", limits);
+}
+
+//Checks the variance of a full window of the longest echoes
+static void check_stats(void)
+{
+	alt_u64 longest = (alt_u64)RANGER_ECHO_TIMEOUT * 2;	//Longest echo after calibration
+	double sum = 0, exact = 0;
+	int i;
+
+	stats_reset();
+	for(i = 0; i < STATS_SAMPLES; i++)
+	{
+		int ticks = (int)(longest - (alt_u64)(i % 7) * 1000);
+
+		stats_add((alt_u64)i, ticks);
+		sum += ticks;
+	}
+	for(i = 0; i < STATS_SAMPLES; i++)					//Deviations from the mean, as doubles can not hold the squares exactly
+	{
+		double deviation = (double)(longest - (alt_u64)(i % 7) * 1000) - sum / STATS_SAMPLES;
+
+		exact += deviation * deviation / STATS_SAMPLES;
+	}
+	printf("variance of the longest echoes           %llu, exact %.0f\n", stats_variance(), exact);
+	check("variance with the longest echoes", fabs((double)stats_variance() - exact) <= 1 + exact * 1e-9);
+	check("mean with the longest echoes", fabs(stats_mean() - sum / STATS_SAMPLES) <= 1);
+}
+
+//Checks the alpha-beta filter follows a target moving at 2m/s across the whole range
+static void check_filter(void)
+{
+	alt_u64 period = TIMING_MS(15);
+	double per_tick = (double)TIMING_HZ * 2 / SOUND_SPEED_MM_S;	//Echo ticks per mm
+	double worst = 0;
+	int i;
+
+	filter_init(FILTER_ALPHA_BETA, 1);
+	for(i = 0; i < 130; i++)							//4m at 2m/s
+	{
+		double mm = 4000 - i * 30.0;
+		int out = filter_add((alt_u64)(i + 1) * period, (int)(mm * per_tick));
+
+		if(i >= 30 && fabs(out / per_tick - mm) > worst)	//Once it has settled
+		{
+			worst = fabs(out / per_tick - mm);
+		}
+	}
+	printf("alpha-beta worst error once settled      %.2f mm\n", worst);
+	check("alpha-beta follows 2m/s", worst < 1);
+}
+
+int main(void)
+{
+	printf("timer %llu Hz, trigger %llu ticks, echo timeout %llu ticks\n",
+		(unsigned long long)TIMING_HZ, (unsigned long long)RANGER_TRIGGER_TICKS, (unsigned long long)RANGER_ECHO_TIMEOUT);
+	check_constants();
+	check_convert();
+	check_stats();
+	check_filter();
+	printf("%s\n", failures ? "FAILED" : "passed");
+	return failures ? 1 : 0;
+}
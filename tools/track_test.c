@@ -0,0 +1,203 @@
+/*
+ * 	Host test of the target tracker(track.h) with readings out of order and repeated.
+ *
+ * 	The median filter hands the tracker readings that are not always newer than the one before, and can hand
+ * 	it the same reading twice. Every reading here lies on one straight line, so whatever order they come in
+ * 	the fit must give the line back: after each reading the prediction at the latest reading still in the
+ * 	window(kept here the same way) must be within TOLERANCE ticks of it, and once two readings are in the
+ * 	window the speed within TOLERANCE_Q8 of its slope. The runs are:
+ * 	- the order that used to leave nothing in the window to fit: 1000, 500, 550, 600 and 650 ms
+ * 	- a moving target given in pairs swapped, with every other reading given twice
+ * 	- random orders and repeats, with now and then a reading from well before the window
+ *
+ * 	Build:	gcc -DHOST_SIM -O2 -I. -o track_test tools/track_test.c track.c convert.c
+ * 	Use:	track_test [readings]		(default 1000000 random, exits 1 if any check fails)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "track.h"
+#include "console.h"
+
+#define TOLERANCE		4						//Ticks the prediction may be off the line, from rounding
+#define TOLERANCE_Q8	64						//Q8 ticks per ms the speed may be off the slope
+
+static const double start_ticks = 300000;		//Echo length of the line at origin, about 1m
+static double origin = 0;						//Time the line starts from, ms
+static double slope = 0;						//Ticks of echo per ms
+static alt_u64 window[TRACK_DEFAULT_WINDOW];	//Times in the tracker's window, kept the same way
+static int count = 0;
+static int next = 0;
+static int failures = 0;
+
+//Console stub, the tracker's commands are not used here
+void console_add(char key, console_fn fn, const char *help)
+{
+	(void)key;
+	(void)fn;
+	(void)help;
+}
+
+//Console stub
+void console_put(const char *str)
+{
+	(void)str;
+}
+
+//Console stub
+void console_put_i32(alt_32 value)
+{
+	(void)value;
+}
+
+//Console stub
+void console_put_line(const char *label, alt_u32 value)
+{
+	(void)label;
+	(void)value;
+}
+
+//Console stub, no number is ever typed
+int console_arg(alt_32 *value)
+{
+	*value = 0;
+	return 0;
+}
+
+//Puts a time in the window as the tracker does and returns the latest time in it
+static alt_u64 window_add(alt_u64 at)
+{
+	alt_u64 latest = 0;
+	int i, seen = 0;
+
+	for(i = 0; i < count; i++)
+	{
+		seen |= window[i] == at;				//Repeats are left out
+		latest = window[i] > latest ? window[i] : latest;
+	}
+	if(!seen)
+	{
+		if(count && at > latest && at - latest > TRACK_SPAN)
+		{
+			count = 0;							//Readings stopped
+			next = 0;
+		}
+		window[next] = at;
+		next = (next + 1) % TRACK_DEFAULT_WINDOW;
+		count += count < TRACK_DEFAULT_WINDOW;
+	}
+	for(latest = 0, i = 0; i < count; i++)
+	{
+		latest = window[i] > latest ? window[i] : latest;
+	}
+	return latest;
+}
+
+//Returns the echo length of the line at the time the sound reached the target
+static int line(alt_u64 at)
+{
+	return (int)(start_ticks + slope * ((double)at * 1000.0 / TIMING_HZ - origin) + 0.5);
+}
+
+//Adds the reading on the line whose echo started at ms, and checks the fit
+static void add(const char *run, double ms)
+{
+	alt_u64 time = (alt_u64)(ms * TIMING_HZ / 1000.0);
+	int ticks = line(time);						//Close enough, the echo is half the change shorter or longer
+	alt_u64 at = time + (alt_u64)(ticks >> 1);
+	alt_u64 latest;
+	int want, got;
+
+	ticks = line(at);
+	at = time + (alt_u64)(ticks >> 1);
+	track_add(time, ticks);
+	latest = window_add(at);
+
+	want = line(latest);
+	got = track_predict(latest);
+	if(abs(got - want) > TOLERANCE && failures++ < 10)
+	{
+		printf("%s: after %.3f ms the fit gives %d, the line %d\n", run, ms, got, want);
+	}
+}
+
+//Checks the speed against the slope
+static void check_speed(const char *run)
+{
+	alt_32 want = (alt_32)(slope * 256.0);
+
+	if(abs(track_speed() - want) > TOLERANCE_Q8 && failures++ < 10)
+	{
+		printf("%s: speed %d Q8, the slope %d\n", run, (int)track_speed(), (int)want);
+	}
+}
+
+//Starts a run on a new line from ms
+static void begin(double new_slope, double ms)
+{
+	track_reset();
+	slope = new_slope;
+	origin = ms;
+	count = 0;
+	next = 0;
+}
+
+int main(int argc, char **argv)
+{
+	int total = argc > 1 ? atoi(argv[1]) : 1000000;
+	double ms;
+	int n;
+
+	begin(0, 0);									//Standing target, the reading at 1000 ms leaves the window last
+	add("late first", 1000);
+	add("late first", 500);
+	add("late first", 550);
+	add("late first", 600);
+	add("late first", 650);
+	add("late first", 700);
+
+	begin(2.9, 0);									//Target moving away at about 0.5 m/s
+	for(ms = 0; ms < 2000; ms += 28)
+	{
+		add("swapped", ms + 14);
+		add("swapped", ms);
+		add("swapped", ms);
+		if(ms > 28)
+		{
+			check_speed("swapped");
+		}
+	}
+
+	srand(1);
+	begin(-5.8, 1000);								//Target closing in at about 1 m/s
+	ms = 1000;
+	for(n = 0; n < total; n++)
+	{
+		double at;
+
+		ms += (rand() % 20) / 2.0;
+		if(rand() % 5000 == 0 || abs(line((alt_u64)(ms * TIMING_HZ / 1000.0)) - (int)start_ticks) > 250000)
+		{
+			begin((rand() % 2001 - 1000) / 100.0, ms);	//A new line now and then, as a new constant read,
+		}											//and before the target leaves the SRF05's range
+		switch(rand() % 16)
+		{
+		case 0:
+			at = ms - 300 - rand() % 300;		//Well before the window
+			break;
+		case 1:
+		case 2:
+			at = ms - (rand() % 20) / 2.0;		//Out of order or repeated
+			break;
+		default:
+			at = ms;
+			break;
+		}
+		add("random", at > 0 ? at : 0);
+	}
+
+	printf("%d random readings, %d failures\n", total, failures);
+	printf("%s\n", failures ? "FAILED" : "passed");
+	return failures ? 1 : 0;
+}
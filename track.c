@@ -0,0 +1,221 @@
+/*
+ * 	Target tracking for constant read mode, see track.h.
+ *
+ * 	The fit is worked out relative to the latest reading: times in microseconds back from it and echo lengths
+ * 	as the difference from the reading added last, which keeps every sum small. The line is then kept as its
+ * 	echo length at the latest reading and its slope, both Q8, the slope per millisecond like the alpha-beta
+ * 	filter's speed. The readings come from the filter, and a median is not always newer than the one before,
+ * 	so they are kept in the order they are added and the latest is the one with the highest time, found
+ * 	again after every reading as the one that was latest may just have left the window.
+ */
+
+#include "track.h"
+#include "convert.h"
+#include "console.h"
+
+#define TRACK_SLOPE_Q		((alt_64)256000)		//Q8 per millisecond from per microsecond
+#define TRACK_GATE			((int)(TIMING_HZ * 2 * TRACK_GATE_MM / SOUND_SPEED_MM_S))	//TRACK_GATE_MM as echo ticks
+#define TRACK_SPEED_MAX		((alt_64)0x7FFFFFFF)	//Largest speed kept, a pair of readings far too close together could give more
+
+TIMING_CHECK(track_fits, (alt_u64)TRACK_MAX * TRACK_MAX * TIMING_TO_US(TRACK_SPAN) * TIMING_TO_US(TRACK_SPAN)
+							<= 0x7FFFFFFFFFFFFFFFull / TRACK_SLOPE_Q);	//Remainder of the slope x Q fits 63 bits
+
+static int window = TRACK_DEFAULT_WINDOW;			//Readings per fit
+static alt_u64 times[TRACK_MAX];					//Time each reading in the window reached the target
+static int values[TRACK_MAX];						//Echo length of each reading in the window
+static int count = 0;								//Readings in the window
+static int newest = 0;								//Position of the reading added last
+
+static alt_u64 reference = 0;						//Time of the latest reading
+static alt_64 position = 0;							//Fitted echo length at reference, Q8
+static alt_64 speed = 0;							//Fitted change in echo length per millisecond, Q8
+static int predicting = 0;							//Display shows the prediction
+
+static alt_u64 error_fit = 0;						//Sum of the differences between each reading and the fit's prediction
+static alt_u64 error_hold = 0;						//Sum of the differences between each reading and the one before
+static alt_u32 scored = 0;							//Readings scored
+static int misses = 0;								//Readings in a row left out as spikes
+static alt_u64 missed = 0;							//Time of the last reading left out
+
+//Clears the window and the error scores
+void track_reset(void)
+{
+	count = 0;
+	newest = 0;
+	reference = 0;
+	position = 0;
+	speed = 0;
+	error_fit = 0;
+	error_hold = 0;
+	scored = 0;
+	misses = 0;
+}
+
+//Fits a line through the readings in the window no older than TRACK_SPAN
+static void track_fit(void)
+{
+	alt_64 n = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+	alt_64 num, den;
+	int base = values[newest];
+	int i;
+
+	for(i = 0; i < count; i++)
+	{
+		alt_u64 age = reference - times[i];
+
+		if(age <= TRACK_SPAN)
+		{
+			alt_64 x = -(alt_64)TIMING_TO_US(age);
+			alt_64 y = (alt_64)values[i] - base;
+
+			n++;
+			sx += x;
+			sy += y;
+			sxx += x * x;
+			sxy += x * y;
+		}
+	}
+	if(n == 0)
+	{
+		return;										//Nothing recent enough, keep the last fit
+	}
+	den = n * sxx - sx * sx;						//Slope = num / den ticks per microsecond
+	num = n * sxy - sx * sy;
+	speed = den > 0 ? (num / den) * TRACK_SLOPE_Q + (num % den) * TRACK_SLOPE_Q / den : 0;
+	speed = speed > TRACK_SPEED_MAX ? TRACK_SPEED_MAX : (speed < -TRACK_SPEED_MAX ? -TRACK_SPEED_MAX : speed);
+	position = ((alt_64)base << 8) + ((sy << 8) - speed * sx / 1000) / n;	//Intercept = (sy - slope x sx) / n
+}
+
+//Adds a reading of ticks whose echo started at time, scoring the prediction made for it first
+void track_add(alt_u64 time, int ticks)
+{
+	alt_u64 at = time + (alt_u64)(ticks >> 1);		//Sound reaches the target half way through the echo
+	int i;
+
+	for(i = 0; i < count; i++)
+	{
+		if(times[i] == at)							//Already in the window, a median filter can give the same reading again
+		{
+			return;
+		}
+	}
+	if(misses && at == missed)
+	{
+		return;
+	}
+	if(count && at > reference && at - reference > TRACK_SPAN)	//Readings stopped, start again
+	{
+		count = 0;
+	}
+
+	if(count >= 2)
+	{
+		int fit = track_predict(at);
+		int held = values[newest];
+
+		error_fit += (alt_u32)(fit > ticks ? fit - ticks : ticks - fit);
+		error_hold += (alt_u32)(held > ticks ? held - ticks : ticks - held);
+		scored++;
+
+		if(fit > ticks + TRACK_GATE || ticks > fit + TRACK_GATE)	//Far off the line
+		{
+			missed = at;
+			if(++misses <= TRACK_GATE_MISSES)		//A spike, unless the next readings agree
+			{
+				return;
+			}
+			count = 0;								//The target jumped, start again
+		}
+	}
+	misses = 0;
+
+	newest = count ? (newest + 1) % window : 0;
+	times[newest] = at;
+	values[newest] = ticks;
+	if(count < window)
+	{
+		count++;
+	}
+	reference = at;									//Latest reading still in the window, a median can be older
+	for(i = 0; i < count; i++)						//than the reading before it and the latest may just have gone
+	{
+		if(times[i] > reference)
+		{
+			reference = times[i];
+		}
+	}
+	track_fit();
+}
+
+//Returns 1 when the display shows the prediction
+int track_predicting(void)
+{
+	return predicting;
+}
+
+//Returns the echo length the fit gives at time, no further than TRACK_HORIZON past the latest reading or TRACK_SPAN before it
+int track_predict(alt_u64 time)
+{
+	alt_64 us;
+	alt_64 at;
+
+	if(time >= reference)
+	{
+		us = (alt_64)TIMING_TO_US(time - reference > TRACK_HORIZON ? TRACK_HORIZON : time - reference);
+	}
+	else
+	{
+		us = -(alt_64)TIMING_TO_US(reference - time > TRACK_SPAN ? TRACK_SPAN : reference - time);
+	}
+	at = position + speed * us / 1000;
+	return at > 0 ? (int)((at + 128) >> 8) : 0;
+}
+
+//Returns the change in echo length per millisecond, Q8, positive while the target moves away
+alt_32 track_speed(void)
+{
+	return (alt_32)speed;
+}
+
+//Returns the speed the target is closing in at in mm/s, negative while it moves away
+alt_32 track_approach(void)
+{
+	alt_64 per_second = speed * 1000 / 256;			//Ticks of echo per second
+
+	return (alt_32)(-per_second * SOUND_SPEED_MM_S / (alt_64)(TIMING_HZ * 2));	//Half the echo is the way back
+}
+
+//Turns the prediction of the display on and off
+static void track_toggle(void)
+{
+	predicting = !predicting;
+	console_put(predicting ? "predict on\n" : "predict off\n");
+}
+
+//Prints the speed, approach rate and prediction error, and sets the window to the number typed
+static void track_report(void)
+{
+	alt_32 size;
+
+	if(console_arg(&size))
+	{
+		window = size < 2 ? 2 : (size > TRACK_MAX ? TRACK_MAX : (int)size);
+		track_reset();
+	}
+	console_put_line("window", (alt_u32)window);
+	console_put("approach mm/s ");
+	console_put_i32(track_approach());
+	console_put_line("\nscored", scored);
+	if(scored)
+	{
+		console_put_line("fit error 0.01mm", (alt_u32)convert_ticks((int)(error_fit / scored), 0, 0));
+		console_put_line("hold error 0.01mm", (alt_u32)convert_ticks((int)(error_hold / scored), 0, 0));
+	}
+}
+
+//Adds the console commands
+void track_init(void)
+{
+	console_add('x', track_toggle, "predict the display to the current time on/off");
+	console_add('v', track_report, "<n>v tracker speed and error, n sets the window");
+}
@@ -0,0 +1,50 @@
+/*
+ * 	Target tracking for constant read mode: velocity and a distance extrapolated to the current time.
+ *
+ * 	A straight line is fitted by least squares through the last window filtered readings(echo length against
+ * 	the time the sound reached the target, half way through the echo), so the slope is the target's speed and
+ * 	the line can be read at any time. Each reading is given the time of the reading the filter's output stands
+ * 	for(filter_time()), so a median's delay is not taken as movement and a spike it removes never reaches the
+ * 	fit. Each reading refits the window, one 64-bit multiply-add per reading in it and two divides. Readings
+ * 	older than TRACK_SPAN are left out, so a stopped reading does not skew a new one. A spike the filter lets
+ * 	through would bend the line for a whole window, so a reading more than TRACK_GATE_MM off it is left out
+ * 	too, unless TRACK_GATE_MISSES in a row are, when the target has jumped and the fit starts again.
+ *
+ * 	A value on the display is at least one reading old by the time it is written. With prediction on, the
+ * 	display and LEDs are given the fit read at the time they are written instead. track_approach() gives the
+ * 	speed the target is closing in at, which lets the alarm zones reach further(alarm_approach()).
+ *
+ * 	Every reading is also used to score the fit: before it is added, the distance the fit predicts for it and
+ * 	the distance held from the last reading are compared with it, so the error with and without prediction can
+ * 	be benchmarked on a recorded trace(hal_host.c SIM_TRACE).
+ *
+ *	<Console Commands>
+ *	x		//Turns the prediction of the display on and off
+ *	<n>v	//Prints the speed, approach rate and prediction error, n sets the window
+ *	<END>>>
+ */
+
+#ifndef TRACK_H_
+#define TRACK_H_
+
+#include "timebase.h"
+
+#define TRACK_MAX			16						//Largest window
+#define TRACK_SPAN			TIMEBASE_MS(200)		//Oldest reading used in a fit
+#define TRACK_HORIZON		TIMEBASE_MS(100)		//Longest extrapolation past the newest reading
+#define TRACK_GATE_MM		100						//Distance off the fit a reading is taken as a spike
+#define TRACK_GATE_MISSES	2						//Spikes in a row after which the target is taken to have moved
+
+#ifndef TRACK_DEFAULT_WINDOW
+#define TRACK_DEFAULT_WINDOW	4					//Readings per fit
+#endif
+
+void track_init(void);								//Adds the console commands
+void track_reset(void);								//Clears the window and the error scores
+void track_add(alt_u64 time, int ticks);			//Adds a reading of ticks whose echo started at time
+int track_predicting(void);							//1 when the display shows the prediction
+int track_predict(alt_u64 time);					//Echo length the fit gives at time
+alt_32 track_speed(void);							//Change in echo length per millisecond, Q8, positive moving away
+alt_32 track_approach(void);						//Speed the target is closing in at in mm/s, negative moving away
+
+#endif /* TRACK_H_ */